@@ -21,6 +21,7 @@
 #define ANIMATION_CONTROL_CMD_SELECT 3
 #define ANIMATION_CONTROL_CMD_BRIGHT 4
 #define ANIMATION_CONTROL_CMD_BRIGHT 4
+#define ANIMATION_CONTROL_CMD_FRAME_RATE 5
 
 // clang-format off
 #define ANM_EN ANIMATION_CONTROL_CMD_ENABLE 1
@@ -30,3 +31,4 @@
 #define ANM_SEL ANIMATION_CONTROL_CMD_SELECT
 #define ANM_BRI ANIMATION_CONTROL_CMD_BRIGHT 1
 #define ANM_BRD ANIMATION_CONTROL_CMD_BRIGHT (-1)
+#define ANM_FPS ANIMATION_CONTROL_CMD_FRAME_RATE
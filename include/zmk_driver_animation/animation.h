@@ -4,7 +4,16 @@
  * SPDX-License-Identifier: MIT
  */
 
+#pragma once
+
 #include <zephyr/device.h>
+#include <zmk_driver_animation/color.h>
+#include <zmk_driver_animation/drivers/animation.h>
+
+/**
+ * Number of pixels of the zmk,animation node.
+ */
+#define ZMK_ANIMATION_NUM_PIXELS DT_PROP_LEN(DT_INST(0, zmk_animation), pixels)
 
 void zmk_animation_request_frames(uint32_t frames);
 
@@ -18,3 +27,90 @@ void zmk_animation_request_frames(uint32_t frames);
  */
 void zmk_animation_request_frames_if_required(uint32_t decremental_counter,
                                               bool initial);
+
+/**
+ * Keep the LED drivers untouched for the given milliseconds, e.g. until the
+ * power rail of the LEDs settles. Frames are still rendered meanwhile.
+ */
+void zmk_animation_delay_output(uint32_t delay_ms);
+
+/**
+ * Number of consecutive frames sent to the LEDs with every LED off, checked
+ * after all output stages such as interpolation, dithering and global
+ * brightness. 0 if the last frame sent lit any LED.
+ */
+uint32_t zmk_animation_get_black_output_frames(void);
+
+/**
+ * Render frames at CONFIG_ZMK_ANIMATION_FPS / divider from now on.
+ * Running animations keep their durations since each render advances them by
+ * `divider` frames, see zmk_animation_get_frame_step().
+ */
+void zmk_animation_set_rate_divider(uint8_t divider);
+
+/**
+ * Number of frames since the animation being rendered was rendered last time.
+ * It's larger than 1 if a parent renders the animation at a divided frame
+ * rate. Time based counters should advance by this value per render.
+ */
+uint32_t zmk_animation_get_frame_step(void);
+
+/**
+ * Frame rate divider of an animation rendered by a parent animation.
+ */
+struct zmk_animation_divider {
+    // the animation is rendered once per `divider` frames of the parent
+    uint8_t divider;
+    uint8_t phase;
+    // last output of the animation, ZMK_ANIMATION_NUM_PIXELS entries
+    struct zmk_color_rgb *held;
+};
+
+/**
+ * Render the animation on the next call to zmk_animation_render_divided().
+ */
+static inline void zmk_animation_divider_reset(
+    struct zmk_animation_divider *divider) {
+    divider->phase = 0;
+}
+
+/**
+ * Render the animation once per divider->divider calls and restore its last
+ * output on the other calls.
+ * Same as animation_render_frame() if CONFIG_ZMK_ANIMATION_FRAME_DIVIDERS is
+ * disabled or the animation is not divided.
+ */
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_FRAME_DIVIDERS)
+void zmk_animation_render_divided(const struct device *animation,
+                                  struct zmk_animation_divider *divider,
+                                  struct animation_pixel *pixels,
+                                  size_t num_pixels);
+#else
+static inline void zmk_animation_render_divided(
+    const struct device *animation, struct zmk_animation_divider *divider,
+    struct animation_pixel *pixels, size_t num_pixels) {
+    animation_render_frame(animation, pixels, num_pixels);
+}
+#endif
+
+/**
+ * Show the frame being rendered as-is instead of interpolating toward it.
+ * Call it from render_frame on hard transitions.
+ * No-op if CONFIG_ZMK_ANIMATION_INTERPOLATION is disabled.
+ */
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_INTERPOLATION)
+void zmk_animation_skip_interpolation(void);
+#else
+static inline void zmk_animation_skip_interpolation(void) {}
+#endif
+
+/**
+ * Drop the cached period of the output frames and render again.
+ * Call it whenever something other than time changes the rendered frames.
+ * No-op if CONFIG_ZMK_ANIMATION_FRAME_CACHE is disabled.
+ */
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_FRAME_CACHE)
+void zmk_animation_invalidate_frame_cache(void);
+#else
+static inline void zmk_animation_invalidate_frame_cache(void) {}
+#endif
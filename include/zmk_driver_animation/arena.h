@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2025 cormoran
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <string.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/toolchain.h>
+
+/**
+ * @file
+ * @brief Transient animation state.
+ *
+ * Animation drivers can keep their running state (counters, particle pools,
+ * cached frames, ...) in a transient state which is claimed in on_start and
+ * released in on_stop. If CONFIG_ZMK_ANIMATION_ARENA is enabled, the state is
+ * taken from a shared arena sized at build time for the worst-case set of
+ * concurrently running animations. Otherwise each instance owns a static
+ * storage defined by ZMK_ANIMATION_STATE_DEFINE().
+ */
+
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_ARENA)
+void *__zmk_animation_arena_claim(size_t size);
+void __zmk_animation_arena_release(void *state);
+#endif
+
+/**
+ * Define per-instance storage for the transient state of the given type.
+ * Nothing is defined if the arena is enabled.
+ */
+#define ZMK_ANIMATION_STATE_DEFINE(name, type)                              \
+    COND_CODE_1(                                                            \
+        CONFIG_ZMK_ANIMATION_ARENA,                                         \
+        (BUILD_ASSERT(sizeof(type) <= CONFIG_ZMK_ANIMATION_ARENA_SLOT_SIZE, \
+                      "Increase CONFIG_ZMK_ANIMATION_ARENA_SLOT_SIZE");),   \
+        (static type name;))
+
+/**
+ * Pointer to the storage defined by ZMK_ANIMATION_STATE_DEFINE() or NULL if the
+ * arena is enabled.
+ */
+#define ZMK_ANIMATION_STATE_STORAGE(name) \
+    COND_CODE_1(CONFIG_ZMK_ANIMATION_ARENA, (NULL), (&name))
+
+/**
+ * Claim zero-initialized transient state.
+ * @param storage storage given by ZMK_ANIMATION_STATE_STORAGE()
+ * @param size size of the state
+ * @return the state or NULL if the arena is exhausted
+ */
+static inline void *zmk_animation_state_claim(void *storage, size_t size) {
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_ARENA)
+    ARG_UNUSED(storage);
+    return __zmk_animation_arena_claim(size);
+#else
+    memset(storage, 0, size);
+    return storage;
+#endif
+}
+
+/**
+ * Release the state claimed by zmk_animation_state_claim().
+ */
+static inline void zmk_animation_state_release(void *state) {
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_ARENA)
+    __zmk_animation_arena_release(state);
+#else
+    ARG_UNUSED(state);
+#endif
+}
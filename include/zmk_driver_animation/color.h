@@ -28,7 +28,16 @@ struct zmk_color_hsl {
     uint8_t l;
 };
 
-#if DT_NODE_HAS_PROP(DT_INST(0, animation), key_position)
+/**
+ * Pixel of key positions which have no pixel.
+ */
+#define ZMK_ANIMATION_PIXEL_NONE SIZE_MAX
+
+#if DT_NODE_HAS_PROP(DT_INST(0, zmk_animation), key_pixels)
+/**
+ * @return pixel of the key position, or ZMK_ANIMATION_PIXEL_NONE if key-pixels
+ * doesn't map it, e.g. keys of the other half of a split keyboard.
+ */
 size_t zmk_animation_get_pixel_by_key_position(size_t key_position);
 #else
 static inline size_t zmk_animation_get_pixel_by_key_position(
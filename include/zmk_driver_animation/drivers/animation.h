@@ -24,6 +24,30 @@
     (ms == ANIMATION_DURATION_FOREVER ? ms  \
                                       : ms * CONFIG_ZMK_ANIMATION_FPS / 1000)
 
+// fields of animation_params set by the caller
+#define ANIMATION_PARAM_COLOR BIT(0)
+#define ANIMATION_PARAM_ORIGIN BIT(1)
+#define ANIMATION_PARAM_SPEED BIT(2)
+#define ANIMATION_PARAM_INTENSITY BIT(3)
+
+/**
+ * Parameters overriding the configuration of an animation for one run, so
+ * one animation instance can play variants of itself. Only fields flagged in
+ * `flags` are set, animations ignore the parameters they don't support.
+ */
+struct animation_params {
+    // ANIMATION_PARAM_* of the fields set
+    uint8_t flags;
+    // 0 (off) to 255 (as configured)
+    uint8_t intensity;
+    // percentage of the configured speed
+    uint16_t speed_percent;
+    // replaces the colors of the animation
+    struct zmk_color_hsl color;
+    // pixel index the animation starts from, e.g. the pressed key
+    uint16_t origin;
+};
+
 struct animation_pixel {
     const uint8_t position_x;
     const uint8_t position_y;
@@ -64,11 +88,67 @@ typedef void (*animation_api_render_frame)(const struct device *dev,
  */
 typedef bool (*animation_api_is_finished)(const struct device *dev);
 
+/**
+ * @typedef animation_api_get_period
+ * @brief Optional callback API to get the period of the rendered frames
+ *
+ * @see animation_get_period() for argument descriptions.
+ */
+typedef uint32_t (*animation_api_get_period)(const struct device *dev);
+
+/**
+ * @typedef animation_api_get_pixel_map
+ * @brief Optional callback API to get the pixels the animation renders to
+ *
+ * @see animation_get_pixel_map() for argument descriptions.
+ */
+typedef size_t (*animation_api_get_pixel_map)(const struct device *dev,
+                                              const size_t **pixel_map);
+
+/**
+ * @typedef animation_api_start_with_params
+ * @brief Optional callback API for starting an animation with parameters.
+ *
+ * @see animation_start_with_params() for argument descriptions.
+ */
+typedef void (*animation_api_start_with_params)(
+    const struct device *dev, uint32_t request_duration_ms,
+    const struct animation_params *params);
+
+/**
+ * @typedef animation_api_contains
+ * @brief Optional callback API to check whether the animation plays another
+ * animation as a part of itself
+ *
+ * @see animation_contains() for argument descriptions.
+ */
+typedef bool (*animation_api_contains)(const struct device *dev,
+                                       const struct device *animation);
+
+/**
+ * @typedef animation_api_shares
+ * @brief Optional callback API to check whether the animation plays any
+ * animation also played by another animation
+ *
+ * @see animation_shares() for argument descriptions.
+ */
+typedef bool (*animation_api_shares)(const struct device *dev,
+                                     const struct device *animation);
+
 struct animation_api {
     animation_api_start on_start;
     animation_api_stop on_stop;
     animation_api_render_frame render_frame;
     animation_api_is_finished is_finished;
+    animation_api_get_period get_period;
+    animation_api_get_pixel_map get_pixel_map;
+    animation_api_start_with_params on_start_with_params;
+    // true if render_frame writes every pixel of the pixel map while the
+    // animation runs. Opaque animations of a parallel animation-compose hide
+    // the animations under them only if this is set.
+    bool fills_pixel_map;
+    animation_api_contains contains;
+    animation_api_shares shares;
 };
 
 /**
@@ -83,6 +163,24 @@ static inline void animation_start(const struct device *dev,
     return api->on_start(dev, request_duration_ms);
 }
 
+/**
+ * Start the animation with parameters for this run. Animations without
+ * on_start_with_params start as animation_start().
+ * @param params parameters or NULL. It's valid only during the call, so the
+ * animation copies what it uses into its state.
+ */
+static inline void animation_start_with_params(
+    const struct device *dev, uint32_t request_duration_ms,
+    const struct animation_params *params) {
+    const struct animation_api *api = (const struct animation_api *)dev->api;
+
+    if (params == NULL || params->flags == 0 ||
+        api->on_start_with_params == NULL) {
+        return api->on_start(dev, request_duration_ms);
+    }
+    return api->on_start_with_params(dev, request_duration_ms, params);
+}
+
 static inline void animation_stop(const struct device *dev) {
     const struct animation_api *api = (const struct animation_api *)dev->api;
 
@@ -102,3 +200,72 @@ static inline bool animation_is_finished(const struct device *dev) {
 
     return api->is_finished(dev);
 }
+
+/**
+ * @return number of frames after which the animation renders the same frames
+ * again as long as nothing but time changes. 0 if the animation is not
+ * periodic.
+ */
+static inline uint32_t animation_get_period(const struct device *dev) {
+    const struct animation_api *api = (const struct animation_api *)dev->api;
+
+    if (api->get_period == NULL) {
+        return 0;
+    }
+    return api->get_period(dev);
+}
+
+/**
+ * @return true if the animation writes every pixel of its pixel map in each
+ * rendered frame, see animation_api.fills_pixel_map.
+ */
+static inline bool animation_fills_pixel_map(const struct device *dev) {
+    const struct animation_api *api = (const struct animation_api *)dev->api;
+
+    return api->fills_pixel_map;
+}
+
+/**
+ * @return true if `animation` is the animation itself or may be played by it,
+ * e.g. a child of animation-compose at any depth.
+ */
+static inline bool animation_contains(const struct device *dev,
+                                      const struct device *animation) {
+    const struct animation_api *api = (const struct animation_api *)dev->api;
+
+    if (dev == animation) {
+        return true;
+    }
+    return api->contains != NULL && api->contains(dev, animation);
+}
+
+/**
+ * @return true if the animation and `animation` can't run at the same time,
+ * i.e. one contains the other or both play a common animation such as the
+ * same child of two animation-compose.
+ */
+static inline bool animation_shares(const struct device *dev,
+                                    const struct device *animation) {
+    const struct animation_api *api = (const struct animation_api *)dev->api;
+
+    if (api->shares == NULL) {
+        return animation_contains(animation, dev);
+    }
+    return api->shares(dev, animation);
+}
+
+/**
+ * @param pixel_map set to the indices of the pixels the animation renders to,
+ * or NULL if the animation can render to any pixel.
+ * @return number of pixels in pixel_map.
+ */
+static inline size_t animation_get_pixel_map(const struct device *dev,
+                                             const size_t **pixel_map) {
+    const struct animation_api *api = (const struct animation_api *)dev->api;
+
+    if (api->get_pixel_map == NULL) {
+        *pixel_map = NULL;
+        return 0;
+    }
+    return api->get_pixel_map(dev, pixel_map);
+}
@@ -35,12 +35,57 @@ enum animation_control_power_source {
  * stops after this duration. If 0, the animation is played until it finishes or
  * canceled.
  *
- * @return 0 on success, negative error code on failure.
+ * @return handle (> 0) of the animation on success, 0 if skipped because the
+ * controller is inactive, negative error code on failure.
  */
 typedef int (*animation_control_api_enqueue_animation)(
     const struct device *dev, const struct device *animation, bool cancelable,
     uint32_t duration_ms);
 
+/**
+ * Ad-hoc animation request with queueing options.
+ */
+struct animation_control_request {
+    const struct device *animation;
+    // see animation_control_api_enqueue_animation
+    bool cancelable;
+    uint32_t duration_ms;
+    // queued requests with higher priority play first, FIFO among the same
+    // priority
+    uint8_t priority;
+    // drop the request unplayed if it doesn't start within this duration.
+    // 0 never expires.
+    uint32_t expiry_ms;
+    // play on top of the playing animation instead of replacing it. Only the
+    // pixels of the animation are overwritten and the playing animation keeps
+    // its phase. Queued as usual if overlay-slots is 0.
+    bool overlay;
+    // play immediately as animation_control_api_play_now, ignoring priority
+    // and expiry
+    bool play_now;
+    // parameters the animation is started with, carried in the queue
+    struct animation_params params;
+};
+
+/**
+ * Submit ad-hoc animation with priority, expiry and parameters.
+ * If the same animation is already queued, the request is merged into it
+ * keeping the higher priority, the longer duration and the later expiry.
+ * If the queue is full, the newest request of the lowest priority is dropped
+ * for a request with higher priority.
+ * Overlay requests start on the next frame. If all overlay slots are used, the
+ * overlay with the lowest priority is replaced by a request with higher
+ * priority, otherwise the request is dropped.
+ * The parameters of the newest request are kept when requests are merged.
+ *
+ * @return handle (> 0) of the request on success, 0 if skipped because the
+ * controller is inactive, -ENOMEM if the queue is full of requests with the
+ * same or higher priority or all handles are in use. A merged request returns
+ * the handle of the queued one.
+ */
+typedef int (*animation_control_api_enqueue_request)(
+    const struct device *dev, const struct animation_control_request *request);
+
 /**
  * Play the animation immediately. Currently playing animation stops regardless
  * of its cancelability. Stopped ad-hoc animation never resumes even after
@@ -54,9 +99,10 @@ typedef int (*animation_control_api_enqueue_animation)(
  * @param duration_ms duration of the animation in milliseconds. The animation
  * stops after this duration. If 0, the animation is played until it finishes or
  * canceled.
- * Caller can stop animation by calling animation_stop(animation) to cancel it.
- * It's ensured that the driver calls aniamtion_start(animation) before
- * returning from this function.
+ * The animation starts on the next frame.
+ *
+ * @return handle (> 0) of the animation on success, negative error code on
+ * failure.
  */
 typedef int (*animation_control_api_play_now)(const struct device *dev,
                                               const struct device *animation,
@@ -115,10 +161,52 @@ typedef int (*animation_control_api_play_now_by_index)(const struct device *dev,
 typedef int (*animation_control_api_stop_by_index)(const struct device *dev,
                                                    uint8_t index);
 
+/**
+ * State of an ad-hoc animation identified by the handle returned from
+ * enqueue or play-now.
+ */
+enum animation_control_handle_state {
+    // finished, canceled, dropped or unknown handle
+    ANIMATION_CONTROL_HANDLE_DONE,
+    // waiting in the queue or for the next frame
+    ANIMATION_CONTROL_HANDLE_QUEUED,
+    ANIMATION_CONTROL_HANDLE_PLAYING,
+};
+
+/**
+ * Cancel the ad-hoc animation regardless of its cancelability. A queued
+ * animation never plays and a playing animation stops on the next frame.
+ * @return 0 on success, -ENOENT if the handle is already done.
+ */
+typedef int (*animation_control_api_cancel)(const struct device *dev,
+                                            int handle);
+
+/**
+ * Extend the duration of the ad-hoc animation. A playing animation which
+ * finishes before the extended duration is started again for the rest.
+ * Animations played until they finish (duration 0) are not affected.
+ * @return 0 on success, -ENOENT if the handle is already done.
+ */
+typedef int (*animation_control_api_extend)(const struct device *dev,
+                                            int handle, uint32_t duration_ms);
+
+typedef enum animation_control_handle_state (*animation_control_api_get_state)(
+    const struct device *dev, int handle);
+
+/**
+ * Render animations at CONFIG_ZMK_ANIMATION_FPS / divider regardless of the
+ * power source. The value is saved to settings.
+ * @param divider frame rate divider. 0 restores the power source policy
+ * (battery-frame-divider and low-battery-frame-divider).
+ */
+typedef void (*animation_control_api_set_frame_divider)(
+    const struct device *dev, uint8_t divider);
+
 struct animation_control_api {
     // animation control behaves as animation_api
     struct animation_api animation_api_base;
     animation_control_api_enqueue_animation enqueue_animation;
+    animation_control_api_enqueue_request enqueue_request;
     animation_control_api_play_now play_now;
     animation_control_api_set_enabled set_enabled;
     animation_control_api_set_next_animation set_next_animation;
@@ -127,6 +215,10 @@ struct animation_control_api {
     animation_control_api_play_now_by_index play_now_by_index;
     animation_control_api_enqueue_by_index enqueue_by_index;
     animation_control_api_stop_by_index stop_by_index;
+    animation_control_api_set_frame_divider set_frame_divider;
+    animation_control_api_cancel cancel;
+    animation_control_api_extend extend;
+    animation_control_api_get_state get_state;
 };
 
 static inline int animation_control_enqueue_animation(
@@ -137,13 +229,20 @@ static inline int animation_control_enqueue_animation(
     return api->enqueue_animation(dev, animation, cancelable, duration_ms);
 }
 
+static inline int animation_control_enqueue_request(
+    const struct device *dev, const struct animation_control_request *request) {
+    const struct animation_control_api *api =
+        (const struct animation_control_api *)dev->api;
+    return api->enqueue_request(dev, request);
+}
+
 static inline int animation_control_play_now(const struct device *dev,
                                              const struct device *animation,
                                              bool cancelable,
                                              uint32_t duration_ms) {
     const struct animation_control_api *api =
         (const struct animation_control_api *)dev->api;
-    return api->enqueue_animation(dev, animation, cancelable, duration_ms);
+    return api->play_now(dev, animation, cancelable, duration_ms);
 }
 
 static inline void animation_control_set_enabled(const struct device *dev,
@@ -202,6 +301,34 @@ static inline int animation_control_stop_by_index(const struct device *dev,
     return api->stop_by_index(dev, index);
 }
 
+static inline void animation_control_set_frame_divider(
+    const struct device *dev, uint8_t divider) {
+    const struct animation_control_api *api =
+        (const struct animation_control_api *)dev->api;
+    return api->set_frame_divider(dev, divider);
+}
+
+static inline int animation_control_cancel(const struct device *dev,
+                                           int handle) {
+    const struct animation_control_api *api =
+        (const struct animation_control_api *)dev->api;
+    return api->cancel(dev, handle);
+}
+
+static inline int animation_control_extend(const struct device *dev,
+                                           int handle, uint32_t duration_ms) {
+    const struct animation_control_api *api =
+        (const struct animation_control_api *)dev->api;
+    return api->extend(dev, handle, duration_ms);
+}
+
+static inline enum animation_control_handle_state animation_control_get_state(
+    const struct device *dev, int handle) {
+    const struct animation_control_api *api =
+        (const struct animation_control_api *)dev->api;
+    return api->get_state(dev, handle);
+}
+
 // workaround to use from behavior without adding compile time dependency
 #if DT_HAS_CHOSEN(zmk_animation_control)
 
@@ -225,4 +352,8 @@ int animation_control_enqueue_animation_by_index0(uint8_t index,
 int animation_control_play_now_by_index0(uint8_t index, bool cancelable,
                                          uint32_t duration_ms);
 int animation_control_stop_by_index0(uint8_t index);
+void animation_control_set_frame_divider0(uint8_t divider);
+int animation_control_cancel0(int handle);
+int animation_control_extend0(int handle, uint32_t duration_ms);
+enum animation_control_handle_state animation_control_get_state0(int handle);
 #endif
@@ -8,14 +8,17 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/led_strip.h>
 #include <zephyr/init.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
 
 #include <zmk/event_manager.h>
 #include <zmk/events/activity_state_changed.h>
+#include <zmk/usb.h>
 #include <zmk_driver_animation/animation.h>
 #include <zmk_driver_animation/color.h>
 #include <zmk_driver_animation/drivers/animation.h>
@@ -69,20 +72,212 @@ static const size_t pixels_size = DT_INST_PROP_LEN(0, pixels);
  */
 static struct led_rgb px_buffer[DT_INST_PROP_LEN(0, pixels)];
 
+#define OUTPUT_REMAP                         \
+    (DT_INST_NODE_HAS_PROP(0, output_map) || \
+     DT_INST_PROP(0, output_rotate) != 0 ||  \
+     DT_INST_PROP(0, output_mirror))
+
+#if OUTPUT_REMAP
+
+#if DT_INST_NODE_HAS_PROP(0, output_map)
+static const uint16_t output_map_config[] = DT_INST_PROP(0, output_map);
+#endif
+
+/**
+ * Physical pixel index in px_buffer for each pixel.
+ * Computed on init from output-map, output-rotate and output-mirror.
+ */
+static uint16_t output_map[DT_INST_PROP_LEN(0, pixels)];
+
+static void zmk_animation_init_output_map(void) {
+    for (size_t i = 0; i < pixels_size; ++i) {
+        output_map[i] = i;
+    }
+
+#if DT_INST_NODE_HAS_PROP(0, output_map)
+    uint8_t seen[DIV_ROUND_UP(DT_INST_PROP_LEN(0, pixels), 8)] = {};
+    bool valid = ARRAY_SIZE(output_map_config) == pixels_size;
+    for (size_t i = 0; valid && i < pixels_size; ++i) {
+        uint16_t to = output_map_config[i];
+        valid       = to < pixels_size && !(seen[to / 8] & BIT(to % 8));
+        if (valid) {
+            seen[to / 8] |= BIT(to % 8);
+        }
+    }
+    if (valid) {
+        memcpy(output_map, output_map_config, sizeof(output_map));
+    } else {
+        LOG_ERR("output-map is not a permutation of pixels, ignored");
+    }
+#endif
+
+    // rotate and mirror pixels in each driver chain
+    const int rotate   = DT_INST_PROP(0, output_rotate);
+    const bool mirror  = DT_INST_PROP(0, output_mirror);
+    size_t chain_start = 0;
+    for (size_t d = 0; d < drivers_size; ++d) {
+        const size_t len = pixels_per_driver[d];
+        for (size_t i = 0; i < pixels_size; ++i) {
+            if (output_map[i] < chain_start ||
+                output_map[i] >= chain_start + len) {
+                continue;
+            }
+            size_t pos = output_map[i] - chain_start;
+            pos        = ((int)pos + rotate % (int)len + len) % len;
+            if (mirror) {
+                pos = len - 1 - pos;
+            }
+            output_map[i] = chain_start + pos;
+        }
+        chain_start += len;
+    }
+}
+
+#define OUTPUT_INDEX(i) output_map[i]
+#else
+#define OUTPUT_INDEX(i) (i)
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_INTERPOLATION)
+#define OUTPUT_STEPS CONFIG_ZMK_ANIMATION_INTERPOLATION_STEPS
+#else
+#define OUTPUT_STEPS 1
+#endif
+
+/**
+ * Runtime frame rate divider. Frames are rendered at
+ * CONFIG_ZMK_ANIMATION_FPS / rate_divider and each render advances animations
+ * by rate_divider frames, so durations are kept.
+ */
+static uint8_t rate_divider = 1;
+
+/**
+ * Smallest rate divider at which the drivers finish sending a frame within
+ * an output frame. Computed on init from chain-lengths.
+ */
+static uint8_t min_rate_divider = 1;
+
+/**
+ * Interval of output frames. Animations are rendered once per OUTPUT_STEPS
+ * output frames.
+ */
+#define OUTPUT_PERIOD                    \
+    K_USEC(USEC_PER_SEC * rate_divider / \
+           (CONFIG_ZMK_ANIMATION_FPS * OUTPUT_STEPS))
+
 /**
- * Counter for animation frames that have been requested but have yet to be
+ * Counter for output frames that have been requested but have yet to be
  * executed.
  */
 static uint32_t animation_timer_countdown = 0;
 
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_INTERPOLATION)
+
+/**
+ * The last two rendered frames. Output frames are interpolated from
+ * keyframes[keyframe_latest ^ 1] to keyframes[keyframe_latest].
+ */
+static struct led_rgb keyframes[2][DT_INST_PROP_LEN(0, pixels)];
+static uint8_t keyframe_latest = 0;
+
+/**
+ * Number of output frames since the latest keyframe (1 ~ OUTPUT_STEPS).
+ * Updated by the timer.
+ */
+static uint8_t output_step = OUTPUT_STEPS;
+
+/**
+ * Set by the timer when the next keyframe should be rendered.
+ */
+static atomic_t keyframe_pending = ATOMIC_INIT(0);
+
+/**
+ * Set by animations to show the keyframe being rendered without interpolation.
+ */
+static bool interpolation_skipped = false;
+
+void zmk_animation_skip_interpolation(void) { interpolation_skipped = true; }
+
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_FRAME_CACHE)
+
+/**
+ * Rendered frames of one period of the root animation.
+ */
+static struct led_rgb frame_cache[CONFIG_ZMK_ANIMATION_FRAME_CACHE_FRAMES]
+                                 [DT_INST_PROP_LEN(0, pixels)];
+
+/**
+ * Period of the cached frames. 0 if the root animation is not periodic.
+ */
+static uint32_t frame_cache_period = 0;
+
+/**
+ * Number of recorded frames. Frames are replayed once a whole period is
+ * recorded.
+ */
+static uint32_t frame_cache_size = 0;
+
+/**
+ * Index of the next frame to replay.
+ */
+static uint32_t frame_cache_position = 0;
+
+static atomic_t frame_cache_invalidated = ATOMIC_INIT(0);
+
+void zmk_animation_invalidate_frame_cache(void) {
+    atomic_set(&frame_cache_invalidated, 1);
+}
+
+static bool zmk_animation_replay_frame_cache(struct led_rgb *buffer) {
+    if (atomic_clear(&frame_cache_invalidated)) {
+        frame_cache_period = 0;
+        frame_cache_size   = 0;
+        return false;
+    }
+    if (frame_cache_period == 0 || frame_cache_size < frame_cache_period) {
+        return false;
+    }
+    memcpy(buffer, frame_cache[frame_cache_position], sizeof(frame_cache[0]));
+    frame_cache_position = (frame_cache_position + 1) % frame_cache_period;
+    // animations don't request frames while replaying
+    zmk_animation_request_frames(1);
+    return true;
+}
+
+static void zmk_animation_record_frame_cache(const struct led_rgb *buffer) {
+    if (frame_cache_period == 0) {
+        uint32_t period = animation_get_period(animation_root);
+        if (period % rate_divider != 0) {
+            // the rendered frames don't repeat at the divided rate
+            return;
+        }
+        period /= rate_divider;
+        if (period == 0 || period > CONFIG_ZMK_ANIMATION_FRAME_CACHE_FRAMES) {
+            return;
+        }
+        LOG_DBG("Record %d frames to frame cache", period);
+        frame_cache_period   = period;
+        frame_cache_size     = 0;
+        frame_cache_position = 0;
+    }
+    memcpy(frame_cache[frame_cache_size++], buffer, sizeof(frame_cache[0]));
+}
+
+#endif
+
 /**
  * Conditional implementation of zmk_animation_get_pixel_by_key_position
  * if key-pixels is set.
  */
-#if DT_INST_NODE_HAS_PROP(0, key_position)
+#if DT_INST_NODE_HAS_PROP(0, key_pixels)
 static const uint8_t pixels_by_key_position[] = DT_INST_PROP(0, key_pixels);
 
 size_t zmk_animation_get_pixel_by_key_position(size_t key_position) {
+    if (key_position >= ARRAY_SIZE(pixels_by_key_position)) {
+        return ZMK_ANIMATION_PIXEL_NONE;
+    }
     return pixels_by_key_position[key_position];
 }
 #endif
@@ -112,11 +307,185 @@ uint8_t zmk_animation_get_pixel_distance(size_t pixel_idx,
 
 #endif
 
-static void zmk_animation_tick(struct k_work *work) {
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_DITHERING)
+
+/**
+ * Fractional remainder of each channel in 1/256 units, carried to the next
+ * frame.
+ */
+static uint8_t dither_error[DT_INST_PROP_LEN(0, pixels)][3];
+
+/**
+ * Set when frames are requested. A static frame is dithered for
+ * CONFIG_ZMK_ANIMATION_DITHERING_FRAMES frames after the last request.
+ */
+static atomic_t dither_frames_requested = ATOMIC_INIT(0);
+static uint32_t dither_frames_left      = 0;
+
+/**
+ * Quantize the channel value adding the remainder of the previous frame.
+ */
+static uint8_t zmk_animation_dither_channel(float value, uint8_t *error) {
+    if (value <= 0) {
+        *error = 0;
+        return 0;
+    }
+    uint32_t fixed = MIN(value, 1.0f) * (UINT8_MAX << 8) + *error;
+    *error         = fixed & 0xff;
+    return fixed >> 8;
+}
+
+/**
+ * Convert the pixel to the output value with temporal dithering.
+ * @return true if a remainder is carried to the next frame.
+ */
+static bool zmk_animation_dither(const struct zmk_color_rgb *rgb,
+                                 struct led_rgb *led, uint8_t error[3]) {
+    led->r = zmk_animation_dither_channel(rgb->r, &error[0]);
+    led->g = zmk_animation_dither_channel(rgb->g, &error[1]);
+    led->b = zmk_animation_dither_channel(rgb->b, &error[2]);
+    return error[0] != 0 || error[1] != 0 || error[2] != 0;
+}
+
+#endif
+
+#define GLOBAL_BRIGHTNESS DT_INST_NODE_HAS_PROP(0, global_brightness)
+
+#if GLOBAL_BRIGHTNESS
+
+BUILD_ASSERT(IS_ENABLED(CONFIG_LED_STRIP_RGB_SCRATCH),
+             "global-brightness is passed in led_rgb.scratch, enable "
+             "CONFIG_LED_STRIP_RGB_SCRATCH");
+BUILD_ASSERT(DT_INST_PROP_LEN(0, global_brightness) ==
+                 DT_INST_PROP_LEN(0, drivers),
+             "global-brightness must have a value for each driver");
+
+#define GLOBAL_BRIGHTNESS_MAX 31
+
+static const uint8_t global_brightness_config[] =
+    DT_INST_PROP(0, global_brightness);
+
+/**
+ * Whether each pixel of px_buffer is sent to a driver with global brightness.
+ * Computed on init.
+ */
+static bool global_brightness[DT_INST_PROP_LEN(0, pixels)];
+
+static void zmk_animation_init_global_brightness(void) {
+    size_t chain_start = 0;
+    for (size_t d = 0; d < drivers_size; ++d) {
+        for (size_t i = chain_start;
+             i < MIN(chain_start + pixels_per_driver[d], pixels_size); ++i) {
+            global_brightness[i] = global_brightness_config[d] != 0;
+        }
+        chain_start += pixels_per_driver[d];
+    }
+}
+
+/**
+ * Split linear channel values in 1 / (255 * GLOBAL_BRIGHTNESS_MAX) units into
+ * the global brightness in led->scratch and 8-bit channel values, keeping the
+ * channel values as large as possible.
+ */
+static void zmk_animation_split_global_brightness(uint32_t r, uint32_t g,
+                                                  uint32_t b,
+                                                  struct led_rgb *led) {
+    const uint32_t level =
+        CLAMP(DIV_ROUND_UP(MAX(r, MAX(g, b)), UINT8_MAX), 1,
+              GLOBAL_BRIGHTNESS_MAX);
+    led->r       = r / level;
+    led->g       = g / level;
+    led->b       = b / level;
+    led->scratch = level;
+}
+
+#endif
+
+/**
+ * Convert the pixel to the output value.
+ * @return true if a dithering remainder is carried to the next frame.
+ */
+static bool zmk_animation_output_pixel(size_t i, struct led_rgb *led) {
+#if GLOBAL_BRIGHTNESS
+    if (global_brightness[OUTPUT_INDEX(i)]) {
+        const float unit                = UINT8_MAX * GLOBAL_BRIGHTNESS_MAX;
+        const struct zmk_color_rgb *rgb = &pixels[i].value;
+        zmk_animation_split_global_brightness(
+            CLAMP(rgb->r, 0.0f, 1.0f) * unit, CLAMP(rgb->g, 0.0f, 1.0f) * unit,
+            CLAMP(rgb->b, 0.0f, 1.0f) * unit, led);
+        return false;
+    }
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_DITHERING)
+    return zmk_animation_dither(&pixels[i].value, led, dither_error[i]);
+#else
+    zmk_rgb_to_led_rgb(&pixels[i].value, led);
+    return false;
+#endif
+}
+
+/**
+ * Frame step of the animation being rendered. Parents multiply it while
+ * rendering divided children.
+ */
+static uint32_t frame_step = 1;
+
+uint32_t zmk_animation_get_frame_step(void) { return frame_step; }
+
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_FRAME_DIVIDERS)
+
+void zmk_animation_render_divided(const struct device *animation,
+                                  struct zmk_animation_divider *divider,
+                                  struct animation_pixel *pixels,
+                                  size_t num_pixels) {
+    if (divider->divider <= 1 || divider->held == NULL) {
+        animation_render_frame(animation, pixels, num_pixels);
+        return;
+    }
+
+    // animations without pixel map hold the whole frame
+    const size_t *pixel_map;
+    size_t pixel_map_size = animation_get_pixel_map(animation, &pixel_map);
+    if (pixel_map == NULL) {
+        pixel_map_size = num_pixels;
+    }
+
+    if (divider->phase == 0) {
+        // the rendered frame is shown for `divider` frames
+        const uint32_t parent_step = frame_step;
+        frame_step                 = parent_step * divider->divider;
+        animation_render_frame(animation, pixels, num_pixels);
+        frame_step = parent_step;
+
+        for (size_t i = 0; i < pixel_map_size; ++i) {
+            size_t pixel         = pixel_map ? pixel_map[i] : i;
+            divider->held[pixel] = pixels[pixel].value;
+        }
+    } else {
+        for (size_t i = 0; i < pixel_map_size; ++i) {
+            size_t pixel        = pixel_map ? pixel_map[i] : i;
+            pixels[pixel].value = divider->held[pixel];
+        }
+    }
+    divider->phase = (divider->phase + 1) % divider->divider;
+}
+
+#endif
+
+static void zmk_animation_render(struct led_rgb *buffer) {
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_FRAME_CACHE)
+    if (zmk_animation_replay_frame_cache(buffer)) {
+        return;
+    }
+#endif
+
+    frame_step = rate_divider;
     animation_render_frame(animation_root, &pixels[0], pixels_size);
 
+    bool dithered = false;
     for (size_t i = 0; i < pixels_size; ++i) {
-        zmk_rgb_to_led_rgb(&pixels[i].value, &px_buffer[i]);
+        dithered |= zmk_animation_output_pixel(i, &buffer[OUTPUT_INDEX(i)]);
 
         // Reset values for the next cycle
         pixels[i].value.r = 0;
@@ -124,7 +493,323 @@ static void zmk_animation_tick(struct k_work *work) {
         pixels[i].value.b = 0;
     }
 
-    size_t pixels_updated = 0;
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_DITHERING)
+    if (atomic_clear(&dither_frames_requested)) {
+        dither_frames_left = CONFIG_ZMK_ANIMATION_DITHERING_FRAMES;
+    } else if (dither_frames_left > 0) {
+        dither_frames_left--;
+    }
+    if (dithered && dither_frames_left > 0) {
+        // remainders are only spread while frames keep coming, a static frame
+        // stops after a while to let the output idle
+        zmk_animation_request_frames(1);
+        atomic_clear(&dither_frames_requested);
+    }
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_FRAME_CACHE)
+    if (dithered) {
+        // replaying would freeze the remainders, record again once frames
+        // are exact
+        zmk_animation_invalidate_frame_cache();
+    } else {
+        zmk_animation_record_frame_cache(buffer);
+    }
+#endif
+}
+
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_INTERPOLATION)
+
+static void zmk_animation_render_keyframe(void) {
+    keyframe_latest ^= 1;
+    interpolation_skipped = false;
+
+    zmk_animation_render(keyframes[keyframe_latest]);
+
+    if (interpolation_skipped) {
+        // hard transition: start the interpolation from the new keyframe
+        memcpy(keyframes[keyframe_latest ^ 1], keyframes[keyframe_latest],
+               sizeof(keyframes[0]));
+    }
+}
+
+/**
+ * Blend the last two keyframes by step / OUTPUT_STEPS into px_buffer.
+ */
+static void zmk_animation_interpolate(uint8_t step) {
+    const struct led_rgb *from = keyframes[keyframe_latest ^ 1];
+    const struct led_rgb *to   = keyframes[keyframe_latest];
+    const uint16_t to_weight   = step;
+    const uint16_t from_weight = OUTPUT_STEPS - step;
+
+    for (size_t i = 0; i < pixels_size; ++i) {
+#if GLOBAL_BRIGHTNESS
+        if (global_brightness[i]) {
+            // blend linear values, global brightness scales the channels
+            zmk_animation_split_global_brightness(
+                (from[i].r * from[i].scratch * from_weight +
+                 to[i].r * to[i].scratch * to_weight) /
+                    OUTPUT_STEPS,
+                (from[i].g * from[i].scratch * from_weight +
+                 to[i].g * to[i].scratch * to_weight) /
+                    OUTPUT_STEPS,
+                (from[i].b * from[i].scratch * from_weight +
+                 to[i].b * to[i].scratch * to_weight) /
+                    OUTPUT_STEPS,
+                &px_buffer[i]);
+            continue;
+        }
+#endif
+        px_buffer[i].r =
+            (from[i].r * from_weight + to[i].r * to_weight) / OUTPUT_STEPS;
+        px_buffer[i].g =
+            (from[i].g * from_weight + to[i].g * to_weight) / OUTPUT_STEPS;
+        px_buffer[i].b =
+            (from[i].b * from_weight + to[i].b * to_weight) / OUTPUT_STEPS;
+    }
+}
+
+#endif
+
+#define OUTPUT_RGBW DT_INST_PROP(0, output_rgbw)
+
+#if OUTPUT_RGBW
+
+BUILD_ASSERT(!GLOBAL_BRIGHTNESS,
+             "output-rgbw and global-brightness both use led_rgb.scratch");
+BUILD_ASSERT(IS_ENABLED(CONFIG_LED_STRIP_RGB_SCRATCH),
+             "output-rgbw carries white in led_rgb.scratch, enable "
+             "CONFIG_LED_STRIP_RGB_SCRATCH");
+BUILD_ASSERT(DT_INST_PROP_LEN(0, white_balance) == 3,
+             "white-balance must have red, green and blue values");
+
+static const uint32_t white_balance[] = DT_INST_PROP(0, white_balance);
+
+/**
+ * Move the component of px_buffer which the white LED can show into the white
+ * channel. The white LED at full value looks like white_balance in RGB.
+ */
+static void zmk_animation_extract_white(void) {
+    for (size_t i = 0; i < pixels_size; ++i) {
+        struct led_rgb *px   = &px_buffer[i];
+        const uint8_t rgb[3] = {px->r, px->g, px->b};
+
+        uint32_t white = UINT8_MAX;
+        for (size_t c = 0; c < 3; ++c) {
+            if (white_balance[c] > 0) {
+                white = MIN(white, rgb[c] * UINT8_MAX / white_balance[c]);
+            }
+        }
+        px->r       = rgb[0] - white * white_balance[0] / UINT8_MAX;
+        px->g       = rgb[1] - white * white_balance[1] / UINT8_MAX;
+        px->b       = rgb[2] - white * white_balance[2] / UINT8_MAX;
+        px->scratch = white;
+    }
+}
+
+#endif
+
+BUILD_ASSERT(DT_INST_PROP_LEN(0, channel_current_ma) == (OUTPUT_RGBW ? 4 : 3),
+             "channel-current-ma must have red, green and blue values, and "
+             "white value with output-rgbw");
+
+static const uint32_t channel_current_ma[] =
+    DT_INST_PROP(0, channel_current_ma);
+
+/**
+ * Estimated current of px_buffer in 1/255 mA.
+ */
+static uint32_t zmk_animation_estimate_current(void) {
+    uint32_t sum_r = 0, sum_g = 0, sum_b = 0;
+    for (size_t i = 0; i < pixels_size; ++i) {
+#if GLOBAL_BRIGHTNESS
+        if (global_brightness[i]) {
+            sum_r += px_buffer[i].r * px_buffer[i].scratch /
+                     GLOBAL_BRIGHTNESS_MAX;
+            sum_g += px_buffer[i].g * px_buffer[i].scratch /
+                     GLOBAL_BRIGHTNESS_MAX;
+            sum_b += px_buffer[i].b * px_buffer[i].scratch /
+                     GLOBAL_BRIGHTNESS_MAX;
+            continue;
+        }
+#endif
+        sum_r += px_buffer[i].r;
+        sum_g += px_buffer[i].g;
+        sum_b += px_buffer[i].b;
+    }
+    uint32_t current = sum_r * channel_current_ma[0] +
+                       sum_g * channel_current_ma[1] +
+                       sum_b * channel_current_ma[2];
+#if OUTPUT_RGBW
+    for (size_t i = 0; i < pixels_size; ++i) {
+        current += px_buffer[i].scratch * channel_current_ma[3];
+    }
+#endif
+    return current;
+}
+
+#define CURRENT_LIMIT                              \
+    (DT_INST_PROP(0, current_budget_usb_ma) > 0 || \
+     DT_INST_PROP(0, current_budget_battery_ma) > 0)
+
+#if CURRENT_LIMIT
+
+/**
+ * Scale px_buffer down if its estimated current exceeds the budget of the
+ * current power source.
+ */
+static void zmk_animation_limit_current(void) {
+    const uint32_t budget_ma = zmk_usb_is_powered()
+                                   ? DT_INST_PROP(0, current_budget_usb_ma)
+                                   : DT_INST_PROP(0, current_budget_battery_ma);
+    if (budget_ma == 0) {
+        return;
+    }
+
+    const uint32_t current = zmk_animation_estimate_current();
+    if (current <= budget_ma * UINT8_MAX) {
+        return;
+    }
+
+    // scale in 1/256 units, always less than 256
+    const uint32_t scale = (uint64_t)budget_ma * UINT8_MAX * 256 / current;
+    for (size_t i = 0; i < pixels_size; ++i) {
+        px_buffer[i].r = px_buffer[i].r * scale >> 8;
+        px_buffer[i].g = px_buffer[i].g * scale >> 8;
+        px_buffer[i].b = px_buffer[i].b * scale >> 8;
+#if OUTPUT_RGBW
+        px_buffer[i].scratch = px_buffer[i].scratch * scale >> 8;
+#endif
+    }
+    LOG_DBG("Estimated LED current %d mA exceeds %d mA, scaled by %d/256",
+            current / UINT8_MAX, budget_ma, scale);
+}
+
+#endif
+
+/**
+ * Time spent sending frames to the drivers, reported periodically.
+ */
+#define TRANSFER_REPORT_INTERVAL_MS 10000
+
+static uint32_t transfer_cycles = 0;
+static uint32_t transfer_frames = 0;
+static int64_t transfer_since   = 0;
+static atomic_t skipped_ticks   = ATOMIC_INIT(0);
+
+static void zmk_animation_init_transfer_time(void) {
+    uint32_t transfer_us = 0;
+    for (size_t i = 0; i < drivers_size; ++i) {
+        transfer_us +=
+            pixels_per_driver[i] * DT_INST_PROP(0, pixel_transfer_us) +
+            DT_INST_PROP(0, transfer_latch_us);
+    }
+    if (transfer_us == 0) {
+        return;
+    }
+
+    const uint32_t output_fps = CONFIG_ZMK_ANIMATION_FPS * OUTPUT_STEPS;
+    min_rate_divider          = CLAMP(
+        DIV_ROUND_UP(transfer_us * output_fps, USEC_PER_SEC), 1, UINT8_MAX);
+    rate_divider = MAX(rate_divider, min_rate_divider);
+    LOG_INF("LED transfer takes %d us, up to %d output fps", transfer_us,
+            USEC_PER_SEC / transfer_us);
+    if (min_rate_divider > 1) {
+        LOG_WRN("%d output fps exceeds LED bus throughput, limited to %d",
+                output_fps, output_fps / min_rate_divider);
+    }
+}
+
+static void zmk_animation_report_transfer(uint32_t cycles) {
+    transfer_cycles += cycles;
+    transfer_frames++;
+
+    const int64_t now = k_uptime_get();
+    if (transfer_since == 0) {
+        transfer_since = now;
+    }
+    const int64_t elapsed_ms = now - transfer_since;
+    if (elapsed_ms < TRANSFER_REPORT_INTERVAL_MS) {
+        return;
+    }
+
+    const uint32_t busy_us = k_cyc_to_us_floor32(transfer_cycles);
+    LOG_DBG("Output %d fps, LED bus %d%% busy, up to %d fps, %d ticks skipped, "
+            "%d mA estimated",
+            (uint32_t)(transfer_frames * MSEC_PER_SEC / elapsed_ms),
+            (uint32_t)(busy_us / (elapsed_ms * 10)),
+            busy_us > 0 ? (uint32_t)((uint64_t)transfer_frames * USEC_PER_SEC /
+                                     busy_us)
+                        : 0,
+            (uint32_t)atomic_clear(&skipped_ticks),
+            zmk_animation_estimate_current() / UINT8_MAX);
+    transfer_cycles = 0;
+    transfer_frames = 0;
+    transfer_since  = now;
+}
+
+/**
+ * Uptime until which the LED drivers are not updated.
+ */
+static int64_t output_resume_time = 0;
+
+void zmk_animation_delay_output(uint32_t delay_ms) {
+    output_resume_time = MAX(output_resume_time, k_uptime_get() + delay_ms);
+}
+
+/**
+ * Number of consecutive output frames sent with every LED off.
+ */
+static uint32_t black_output_frames = 0;
+
+uint32_t zmk_animation_get_black_output_frames(void) {
+    return black_output_frames / OUTPUT_STEPS;
+}
+
+static bool zmk_animation_is_output_black(void) {
+    for (size_t i = 0; i < pixels_size; ++i) {
+        const struct led_rgb *px = &px_buffer[i];
+        if (px->r != 0 || px->g != 0 || px->b != 0) {
+            return false;
+        }
+#if OUTPUT_RGBW
+        if (px->scratch != 0) {
+            return false;
+        }
+#endif
+    }
+    return true;
+}
+
+static void zmk_animation_tick(struct k_work *work) {
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_INTERPOLATION)
+    if (atomic_clear(&keyframe_pending)) {
+        zmk_animation_render_keyframe();
+    }
+    zmk_animation_interpolate(output_step);
+#else
+    zmk_animation_render(px_buffer);
+#endif
+
+    if (k_uptime_get() < output_resume_time) {
+        // keep frames coming until the output resumes
+        zmk_animation_request_frames(1);
+        return;
+    }
+
+#if OUTPUT_RGBW
+    zmk_animation_extract_white();
+#endif
+
+#if CURRENT_LIMIT
+    zmk_animation_limit_current();
+#endif
+
+    black_output_frames =
+        zmk_animation_is_output_black() ? black_output_frames + 1 : 0;
+
+    size_t pixels_updated         = 0;
+    const uint32_t transfer_start = k_cycle_get_32();
 
     for (size_t i = 0; i < drivers_size; ++i) {
         led_strip_update_rgb(drivers[i], &px_buffer[pixels_updated],
@@ -132,11 +817,28 @@ static void zmk_animation_tick(struct k_work *work) {
 
         pixels_updated += pixels_per_driver[i];
     }
+
+    zmk_animation_report_transfer(k_cycle_get_32() - transfer_start);
 }
 
 K_WORK_DEFINE(animation_work, zmk_animation_tick);
 
 static void zmk_animation_tick_handler(struct k_timer *timer) {
+    if (k_work_busy_get(&animation_work) != 0) {
+        // the previous frame is still being rendered or sent, retry on the
+        // next tick instead of queueing frames behind it
+        atomic_inc(&skipped_ticks);
+        return;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_INTERPOLATION)
+    if (output_step == OUTPUT_STEPS) {
+        output_step = 0;
+        atomic_set(&keyframe_pending, 1);
+    }
+    output_step++;
+#endif
+
     if (--animation_timer_countdown == 0) {
         k_timer_stop(timer);
     }
@@ -147,16 +849,46 @@ static void zmk_animation_tick_handler(struct k_timer *timer) {
 K_TIMER_DEFINE(animation_tick, zmk_animation_tick_handler, NULL);
 
 void zmk_animation_request_frames(uint32_t frames) {
-    if (frames <= animation_timer_countdown) {
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_DITHERING)
+    atomic_set(&dither_frames_requested, 1);
+#endif
+
+    // frames are counted at the full frame rate
+    frames = DIV_ROUND_UP(frames, rate_divider);
+
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_INTERPOLATION)
+    // finish interpolation toward the current keyframe before the requested
+    // frames. countdown stays aligned to keyframes.
+    uint32_t ticks = frames * OUTPUT_STEPS + (OUTPUT_STEPS - output_step);
+#else
+    uint32_t ticks = frames;
+#endif
+
+    if (ticks <= animation_timer_countdown) {
         return;
     }
 
     if (animation_timer_countdown == 0) {
-        k_timer_start(&animation_tick, K_MSEC(1000 / CONFIG_ZMK_ANIMATION_FPS),
-                      K_MSEC(1000 / CONFIG_ZMK_ANIMATION_FPS));
+        k_timer_start(&animation_tick, OUTPUT_PERIOD, OUTPUT_PERIOD);
     }
 
-    animation_timer_countdown = frames;
+    animation_timer_countdown = ticks;
+}
+
+void zmk_animation_set_rate_divider(uint8_t divider) {
+    divider = MAX(divider, min_rate_divider);
+    if (divider == rate_divider) {
+        return;
+    }
+    LOG_INF("Animation frame rate %d -> %d fps",
+            CONFIG_ZMK_ANIMATION_FPS / rate_divider,
+            CONFIG_ZMK_ANIMATION_FPS / divider);
+    rate_divider = divider;
+    zmk_animation_invalidate_frame_cache();
+    if (animation_timer_countdown > 0) {
+        // running animations continue with the new period
+        k_timer_start(&animation_tick, OUTPUT_PERIOD, OUTPUT_PERIOD);
+    }
 }
 
 void zmk_animation_request_frames_if_required(uint32_t decrenetal_counter,
@@ -166,7 +898,8 @@ void zmk_animation_request_frames_if_required(uint32_t decrenetal_counter,
                                              CONFIG_ZMK_ANIMATION_FPS
                                          ? CONFIG_ZMK_ANIMATION_FPS
                                          : decrenetal_counter);
-    } else if (decrenetal_counter % CONFIG_ZMK_ANIMATION_FPS == 0) {
+    } else if (decrenetal_counter % CONFIG_ZMK_ANIMATION_FPS < frame_step) {
+        // the counter crossed a multiple of FPS since the last render
         zmk_animation_request_frames(CONFIG_ZMK_ANIMATION_FPS);
     }
 }
@@ -181,6 +914,7 @@ static int zmk_animation_on_activity_state_changed(const zmk_event_t *event) {
 
     switch (activity_state_event->state) {
         case ZMK_ACTIVITY_ACTIVE:
+            zmk_animation_invalidate_frame_cache();
             animation_start(animation_root, ANIMATION_DURATION_FOREVER);
             return 0;
 #if defined(CONFIG_ZMK_ANIMATION_STOP_ON_IDLE) && \
@@ -189,8 +923,12 @@ static int zmk_animation_on_activity_state_changed(const zmk_event_t *event) {
 #endif
         case ZMK_ACTIVITY_SLEEP:
             animation_stop(animation_root);
+            zmk_animation_invalidate_frame_cache();
             k_timer_stop(&animation_tick);
             animation_timer_countdown = 0;
+#if IS_ENABLED(CONFIG_ZMK_ANIMATION_INTERPOLATION)
+            output_step = OUTPUT_STEPS;
+#endif
             return 0;
         default:
             return 0;
@@ -214,6 +952,16 @@ static int zmk_animation_init(const struct device *dev) {
     }
 #endif
 
+#if OUTPUT_REMAP
+    zmk_animation_init_output_map();
+#endif
+
+    zmk_animation_init_transfer_time();
+
+#if GLOBAL_BRIGHTNESS
+    zmk_animation_init_global_brightness();
+#endif
+
     LOG_INF("ZMK Animation Ready");
     animation_start(animation_root, ANIMATION_DURATION_FOREVER);
 
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2025 cormoran
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_animation_apa102
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/led_strip.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+/*
+ * APA102 / SK9822 driver which sends led_rgb.scratch as the 5-bit global
+ * brightness of each LED. See global-brightness of zmk,animation.
+ */
+
+BUILD_ASSERT(IS_ENABLED(CONFIG_LED_STRIP_RGB_SCRATCH),
+             "zmk,animation-apa102 takes global brightness from "
+             "led_rgb.scratch, enable CONFIG_LED_STRIP_RGB_SCRATCH");
+
+#define APA102_START_FRAME_BYTES 4
+#define APA102_BYTES_PER_LED 4
+#define APA102_GLOBAL_BRIGHTNESS_MAX 31
+// SK9822 needs 32 bits of reset frame, both need a clock edge per 2 LEDs
+#define APA102_END_FRAME_BYTES(length) (4 + DIV_ROUND_UP(length, 16))
+
+#define SPI_OPER                                               \
+    (SPI_OP_MODE_MASTER | SPI_TRANSFER_MSB | SPI_WORD_SET(8) | \
+     SPI_LINES_SINGLE)
+
+struct apa102_config {
+    struct spi_dt_spec bus;
+    uint8_t *px_buf;
+    size_t px_buf_size;
+    size_t length;
+};
+
+static int apa102_update_rgb(const struct device *dev, struct led_rgb *pixels,
+                             size_t num_pixels) {
+    const struct apa102_config *config = dev->config;
+
+    if (num_pixels > config->length) {
+        LOG_ERR("%zu pixels exceed chain length %zu", num_pixels,
+                config->length);
+        return -EINVAL;
+    }
+
+    // start and end frames stay zero
+    uint8_t *led = &config->px_buf[APA102_START_FRAME_BYTES];
+    for (size_t i = 0; i < num_pixels; ++i, led += APA102_BYTES_PER_LED) {
+        led[0] = 0xe0 | MIN(pixels[i].scratch, APA102_GLOBAL_BRIGHTNESS_MAX);
+        led[1] = pixels[i].b;
+        led[2] = pixels[i].g;
+        led[3] = pixels[i].r;
+    }
+
+    const struct spi_buf buf = {
+        .buf = config->px_buf,
+        .len = config->px_buf_size,
+    };
+    const struct spi_buf_set tx = {
+        .buffers = &buf,
+        .count   = 1,
+    };
+    int rc = spi_write_dt(&config->bus, &tx);
+    if (rc != 0) {
+        LOG_ERR("Failed to write pixels: %d", rc);
+    }
+    return rc;
+}
+
+static int apa102_update_channels(const struct device *dev, uint8_t *channels,
+                                  size_t num_channels) {
+    return -ENOTSUP;
+}
+
+static int apa102_init(const struct device *dev) {
+    const struct apa102_config *config = dev->config;
+
+    if (!spi_is_ready_dt(&config->bus)) {
+        LOG_ERR("SPI device %s not ready", config->bus.bus->name);
+        return -ENODEV;
+    }
+
+    // LEDs beyond the updated pixels are sent as off
+    for (size_t i = 0; i < config->length; ++i) {
+        config->px_buf[APA102_START_FRAME_BYTES + i * APA102_BYTES_PER_LED] =
+            0xe0;
+    }
+
+    return 0;
+}
+
+static const struct led_strip_driver_api apa102_api = {
+    .update_rgb      = apa102_update_rgb,
+    .update_channels = apa102_update_channels,
+};
+
+#define APA102_BUF_SIZE(idx)                                  \
+    (APA102_START_FRAME_BYTES +                               \
+     DT_INST_PROP(idx, chain_length) * APA102_BYTES_PER_LED + \
+     APA102_END_FRAME_BYTES(DT_INST_PROP(idx, chain_length)))
+
+#define APA102_DEVICE(idx)                                      \
+                                                                \
+    static uint8_t apa102_##idx##_px_buf[APA102_BUF_SIZE(idx)]; \
+                                                                \
+    static const struct apa102_config apa102_##idx##_config = { \
+        .bus         = SPI_DT_SPEC_INST_GET(idx, SPI_OPER, 0),  \
+        .px_buf      = apa102_##idx##_px_buf,                   \
+        .px_buf_size = APA102_BUF_SIZE(idx),                    \
+        .length      = DT_INST_PROP(idx, chain_length),         \
+    };                                                          \
+                                                                \
+    DEVICE_DT_INST_DEFINE(idx, &apa102_init, NULL, NULL,        \
+                          &apa102_##idx##_config, POST_KERNEL,  \
+                          CONFIG_LED_STRIP_INIT_PRIORITY, &apa102_api);
+
+DT_INST_FOREACH_STATUS_OKAY(APA102_DEVICE);
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2025 cormoran
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+
+#include <zmk_driver_animation/arena.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+/*
+ * The arena is sized from the animation graph under the root animation.
+ * Every animation which is not animation-compose counts one slot.
+ * - animation-control plays one animation at a time: max of its animations,
+ *   plus one for the outgoing animation with crossfade-ms and one for each
+ *   overlay slot
+ * - sequential animation-compose plays one child at a time: max of children
+ * - parallel animation-compose plays all children: sum of children
+ *
+ * Preprocessor can't recurse, so each nesting level of animation-compose has
+ * its own set of macros.
+ */
+
+#define ARENA_TOO_DEEP 0x10000
+
+#define ARENA_MAX_MEMBER(slots, idx) char _##idx[slots];
+
+#define ARENA_COMPOSE_SLOTS(node_id, sum, max) \
+    (DT_PROP(node_id, parallel) ? (0 sum) : sizeof(union { max }))
+
+// level 3: deeper animation-compose is not supported
+#define ARENA_NODE_SLOTS_3(node_id)                                 \
+    COND_CODE_1(DT_NODE_HAS_COMPAT(node_id, zmk_animation_compose), \
+                (ARENA_TOO_DEEP), (1))
+
+// level 2
+#define ARENA_SUM_2(node_id, prop, idx, ...) \
+    +ARENA_NODE_SLOTS_3(DT_PHANDLE_BY_IDX(node_id, prop, idx))
+#define ARENA_MAX_2(node_id, prop, idx, ...) \
+    ARENA_MAX_MEMBER(                        \
+        ARENA_NODE_SLOTS_3(DT_PHANDLE_BY_IDX(node_id, prop, idx)), idx)
+#define ARENA_NODE_SLOTS_2(node_id)                              \
+    COND_CODE_1(                                                 \
+        DT_NODE_HAS_COMPAT(node_id, zmk_animation_compose),      \
+        (ARENA_COMPOSE_SLOTS(                                    \
+            node_id,                                             \
+            DT_FOREACH_PROP_ELEM_SEP_VARGS(node_id, animations,  \
+                                           ARENA_SUM_2, (), ),   \
+            DT_FOREACH_PROP_ELEM_SEP_VARGS(node_id, animations,  \
+                                           ARENA_MAX_2, (), ))), \
+        (1))
+
+// level 1
+#define ARENA_SUM_1(node_id, prop, idx, ...) \
+    +ARENA_NODE_SLOTS_2(DT_PHANDLE_BY_IDX(node_id, prop, idx))
+#define ARENA_MAX_1(node_id, prop, idx, ...) \
+    ARENA_MAX_MEMBER(                        \
+        ARENA_NODE_SLOTS_2(DT_PHANDLE_BY_IDX(node_id, prop, idx)), idx)
+#define ARENA_NODE_SLOTS_1(node_id)                                           \
+    COND_CODE_1(                                                              \
+        DT_NODE_HAS_COMPAT(node_id, zmk_animation_compose),                   \
+        (ARENA_COMPOSE_SLOTS(                                                 \
+            node_id,                                                          \
+            DT_FOREACH_PROP_ELEM_VARGS(node_id, animations, ARENA_SUM_1, ),   \
+            DT_FOREACH_PROP_ELEM_VARGS(node_id, animations, ARENA_MAX_1, ))), \
+        (1))
+
+// level 0: animations played by animation-control
+#define ARENA_CONTROL_MEMBER(node_id, prop, idx) \
+    ARENA_MAX_MEMBER(                            \
+        ARENA_NODE_SLOTS_1(DT_PHANDLE_BY_IDX(node_id, prop, idx)), prop##_##idx)
+#define ARENA_CONTROL_OPTIONAL_MEMBER(node_id, prop)                       \
+    COND_CODE_1(DT_NODE_HAS_PROP(node_id, prop),                           \
+                (ARENA_MAX_MEMBER(                                         \
+                    ARENA_NODE_SLOTS_1(DT_PHANDLE(node_id, prop)), prop)), \
+                ())
+// animations animation-control can run at the same time
+#define ARENA_CONTROL_CONCURRENCY(node_id)      \
+    (1 + (DT_PROP(node_id, crossfade_ms) > 0) + \
+     DT_PROP(node_id, overlay_slots))
+#define ARENA_CONTROL_SLOTS(node_id)                                 \
+    (ARENA_CONTROL_CONCURRENCY(node_id) * sizeof(union {             \
+        char _root[1];                                               \
+        DT_FOREACH_PROP_ELEM(node_id, powered_animations,            \
+                             ARENA_CONTROL_MEMBER)                   \
+        DT_FOREACH_PROP_ELEM(node_id, battery_animations,            \
+                             ARENA_CONTROL_MEMBER)                   \
+        DT_FOREACH_PROP_ELEM(node_id, behavior_animations,           \
+                             ARENA_CONTROL_MEMBER)                   \
+        ARENA_CONTROL_OPTIONAL_MEMBER(node_id, init_animation)       \
+        ARENA_CONTROL_OPTIONAL_MEMBER(node_id, activation_animation) \
+    }))
+#define ARENA_NODE_SLOTS_0(node_id)                                 \
+    COND_CODE_1(DT_NODE_HAS_COMPAT(node_id, zmk_animation_control), \
+                (ARENA_CONTROL_SLOTS(node_id)),                     \
+                (ARENA_NODE_SLOTS_1(node_id)))
+
+#define ARENA_NUM_SLOTS ARENA_NODE_SLOTS_0(DT_CHOSEN(zmk_animation))
+
+BUILD_ASSERT(ARENA_NUM_SLOTS < ARENA_TOO_DEEP,
+             "animation-compose is nested too deeply to size the arena");
+
+#define ARENA_SLOT_SIZE \
+    ROUND_UP(CONFIG_ZMK_ANIMATION_ARENA_SLOT_SIZE, sizeof(void *))
+
+/**
+ * Backing storage of the arena. Each slot holds the state of one animation.
+ */
+static uint8_t __aligned(sizeof(void *))
+    arena[ARENA_NUM_SLOTS][ARENA_SLOT_SIZE];
+
+ATOMIC_DEFINE(arena_used, ARENA_NUM_SLOTS);
+
+void *__zmk_animation_arena_claim(size_t size) {
+    if (size > CONFIG_ZMK_ANIMATION_ARENA_SLOT_SIZE) {
+        LOG_ERR("Animation state %zu exceeds arena slot size %d", size,
+                CONFIG_ZMK_ANIMATION_ARENA_SLOT_SIZE);
+        return NULL;
+    }
+    for (size_t i = 0; i < ARENA_NUM_SLOTS; i++) {
+        if (!atomic_test_and_set_bit(arena_used, i)) {
+            memset(arena[i], 0, ARENA_SLOT_SIZE);
+            return arena[i];
+        }
+    }
+    LOG_ERR("Animation arena exhausted (%zu slots)", (size_t)ARENA_NUM_SLOTS);
+    return NULL;
+}
+
+void __zmk_animation_arena_release(void *state) {
+    if (state == NULL) {
+        return;
+    }
+    size_t i = ((uint8_t *)state - &arena[0][0]) / ARENA_SLOT_SIZE;
+    if (i >= ARENA_NUM_SLOTS) {
+        LOG_ERR("Released state %p is not from the animation arena", state);
+        return;
+    }
+    atomic_clear_bit(arena_used, i);
+}
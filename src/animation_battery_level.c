@@ -88,7 +88,8 @@ static void animation_battery_status_render_frame(
         zmk_hsl_to_rgb(&color, &rgb);
         pixels[config->pixel_map[i]].value = rgb;
     }
-    data->counter = counter - 1;
+    uint32_t step = zmk_animation_get_frame_step();
+    data->counter = counter > step ? counter - step : 0;
     zmk_animation_request_frames_if_required(data->counter, false);
     if (data->counter == 0) {
         animation_stop(dev);
@@ -133,20 +134,35 @@ void on_battery_status_change(const struct device *dev) {
             level < config->low_alert_start_threshold &&
             k_uptime_get() - data->last_alert_time >
                 config->low_alert_interval_millis) {
-            animation_control_enqueue_animation(animation_control, dev, false,
-                                                config->low_alert_duration_ms);
+            // the alert is stale if it can't be shown in time
+            const struct animation_control_request request = {
+                .animation   = dev,
+                .duration_ms = config->low_alert_duration_ms,
+                .expiry_ms   = config->low_alert_duration_ms,
+                .overlay     = true,
+            };
+            animation_control_enqueue_request(animation_control, &request);
         }
         return;
     }
 }
 
+static size_t animation_battery_status_get_pixel_map(
+    const struct device *dev, const size_t **pixel_map) {
+    const struct animation_battery_status_config *config = dev->config;
+    *pixel_map                                           = config->pixel_map;
+    return config->pixel_map_size;
+}
+
 static int animation_battery_status_init(const struct device *dev) { return 0; }
 
 static const struct animation_api animation_battery_status_api = {
-    .on_start     = animation_battery_status_start,
-    .on_stop      = animation_battery_status_stop,
-    .render_frame = animation_battery_status_render_frame,
-    .is_finished  = animation_battery_status_is_finished,
+    .on_start        = animation_battery_status_start,
+    .on_stop         = animation_battery_status_stop,
+    .render_frame    = animation_battery_status_render_frame,
+    .is_finished     = animation_battery_status_is_finished,
+    .get_pixel_map   = animation_battery_status_get_pixel_map,
+    .fills_pixel_map = true,
 };
 
 #define ANIMATION_BATTERY_STATUS_DEVICE(idx)                                   \
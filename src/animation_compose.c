@@ -19,83 +19,329 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 struct animation_compose_config {
     struct device **animations;
     uint32_t *durations;
+    struct zmk_animation_divider *dividers;
     uint8_t num_animations;
     bool parallel;
+    // last output of divided animations
+    struct zmk_color_rgb (*held)[ZMK_ANIMATION_NUM_PIXELS];
+    uint8_t num_held;
+    // storage for the union of pixel maps of animations
+    size_t *pixel_map;
+    // parallel compose: blending-mode of each animation, opacity 0 to 255
+    const uint8_t *blending_modes;
+    const uint8_t *opacities;
+    // parallel compose: animations skipped in the current frame since opaque
+    // animations above cover all their pixels
+    bool *culled;
+    // parallel compose: pixels under the animation being blended
+    struct zmk_color_rgb *under;
+    // sequential compose: durations-ms fitted to the requested duration
+    uint32_t *timeline;
+    // sequential compose: scale durations-ms to the requested duration
+    // instead of truncating them
+    bool scale_timeline;
 };
 
+// Mutated only in the render context: render_frame and start/stop called by
+// the parent animation.
 struct animation_compose_data {
     bool running;
     uint8_t current_index;
-    struct k_mutex mutex;
+    // sequential compose: frames left of the current animation,
+    // ANIMATION_DURATION_FOREVER until it finishes by itself
+    uint32_t frames_left;
+    // sequential compose: frames left of the requested duration,
+    // ANIMATION_DURATION_FOREVER if not requested
+    uint32_t budget_frames;
+    // parameters given to each animation on start
+    struct animation_params params;
+    bool pixel_map_ready;
+    // true if any animation can render to any pixel
+    bool pixel_map_all;
+    size_t pixel_map_size;
 };
 
+// marks pixels which the animation didn't render to
+#define COMPOSE_TRANSPARENT -1.0f
+
+/*
+ * Blend kernels of premultiplied source `s` with opacity `a` over the opaque
+ * destination `d`, i.e. a * blend(d, s / a) + (1 - a) * d.
+ */
+static inline float blend_normal(float d, float s, float a) {
+    return s + d * (1.0f - a);
+}
+static inline float blend_multiply(float d, float s, float a) {
+    return d * (1.0f - a) + d * s;
+}
+static inline float blend_lighten(float d, float s, float a) {
+    return d + MAX(s - a * d, 0.0f);
+}
+static inline float blend_darken(float d, float s, float a) {
+    return d - MAX(a * d - s, 0.0f);
+}
+static inline float blend_screen(float d, float s, float a) {
+    return d + s - d * s;
+}
+static inline float blend_subtract(float d, float s, float a) {
+    return d - d * s;
+}
+
+/*
+ * Pixels the animation didn't render keep the pixels under it, which are still
+ * transparent if this compose is blended by a parent compose. Rendered pixels
+ * are blended over black there, so the sentinel never leaks into colors.
+ */
+#define BLEND_LOOP(kernel)                                                 \
+    for (size_t i = 0; i < size; ++i) {                                    \
+        struct zmk_color_rgb *src       = &pixels[map ? map[i] : i].value; \
+        const struct zmk_color_rgb *dst = &under[i];                       \
+        if (src->r == COMPOSE_TRANSPARENT) {                               \
+            *src = *dst;                                                   \
+            continue;                                                      \
+        }                                                                  \
+        if (dst->r == COMPOSE_TRANSPARENT) {                               \
+            dst = &black;                                                  \
+        }                                                                  \
+        src->r = kernel(dst->r, src->r * alpha, alpha);                    \
+        src->g = kernel(dst->g, src->g * alpha, alpha);                    \
+        src->b = kernel(dst->b, src->b * alpha, alpha);                    \
+    }
+
+static inline bool is_opaque(const struct animation_compose_config *config,
+                             int index) {
+    return config->blending_modes[index] ==
+               ZMK_ANIMATION_BLENDING_MODE_NORMAL &&
+           config->opacities[index] == UINT8_MAX;
+}
+
+/**
+ * Render the animation and blend it over the pixels rendered so far. Opaque
+ * animations overwrite the pixels they render to as they do by themselves.
+ */
+static void render_blended(const struct device *dev, int index,
+                           struct animation_pixel *pixels,
+                           size_t num_pixels) {
+    const struct animation_compose_config *config = dev->config;
+    const struct device *animation                = config->animations[index];
+    if (is_opaque(config, index)) {
+        zmk_animation_render_divided(animation, &config->dividers[index],
+                                     pixels, num_pixels);
+        return;
+    }
+
+    const size_t *map;
+    size_t size = animation_get_pixel_map(animation, &map);
+    if (map == NULL) {
+        size = num_pixels;
+    }
+    struct zmk_color_rgb *under            = config->under;
+    const struct zmk_color_rgb transparent = {.r = COMPOSE_TRANSPARENT};
+    for (size_t i = 0; i < size; ++i) {
+        struct zmk_color_rgb *value = &pixels[map ? map[i] : i].value;
+        under[i]                    = *value;
+        *value                      = transparent;
+    }
+
+    zmk_animation_render_divided(animation, &config->dividers[index], pixels,
+                                 num_pixels);
+
+    const float alpha = config->opacities[index] / (float)UINT8_MAX;
+    // under pixels left transparent by a parent compose
+    const struct zmk_color_rgb black = {};
+    switch (config->blending_modes[index]) {
+        case ZMK_ANIMATION_BLENDING_MODE_MULTIPLY:
+            BLEND_LOOP(blend_multiply);
+            break;
+        case ZMK_ANIMATION_BLENDING_MODE_LIGHTEN:
+            BLEND_LOOP(blend_lighten);
+            break;
+        case ZMK_ANIMATION_BLENDING_MODE_DARKEN:
+            BLEND_LOOP(blend_darken);
+            break;
+        case ZMK_ANIMATION_BLENDING_MODE_SCREEN:
+            BLEND_LOOP(blend_screen);
+            break;
+        case ZMK_ANIMATION_BLENDING_MODE_SUBTRACT:
+            BLEND_LOOP(blend_subtract);
+            break;
+        default:
+            BLEND_LOOP(blend_normal);
+            break;
+    }
+}
+
+/**
+ * Mark animations whose pixels are all covered by opaque animations above
+ * them. Only opaque animations which fill their pixel map cover pixels, others
+ * may leave pixels to the animations under them. Culled animations are not
+ * rendered and don't advance in the frame.
+ */
+static void cull_occluded(const struct device *dev) {
+    const struct animation_compose_config *config = dev->config;
+    uint8_t covered[DIV_ROUND_UP(ZMK_ANIMATION_NUM_PIXELS, 8)] = {};
+    bool all_covered                                           = false;
+
+    for (int i = config->num_animations - 1; i >= 0; --i) {
+        config->culled[i] = all_covered;
+        if (all_covered || animation_is_finished(config->animations[i])) {
+            continue;
+        }
+        bool covers = is_opaque(config, i) &&
+                      animation_fills_pixel_map(config->animations[i]);
+        const size_t *map;
+        size_t size = animation_get_pixel_map(config->animations[i], &map);
+        if (map == NULL) {
+            all_covered = covers;
+            continue;
+        }
+        bool visible = false;
+        for (size_t j = 0; j < size && !visible; ++j) {
+            visible = !(covered[map[j] / 8] & BIT(map[j] % 8));
+        }
+        config->culled[i] = !visible;
+        if (visible && covers) {
+            for (size_t j = 0; j < size; ++j) {
+                covered[map[j] / 8] |= BIT(map[j] % 8);
+            }
+        }
+    }
+}
+
 void render_frame_for_parallel(const struct device *dev,
                                struct animation_pixel *pixels,
                                size_t num_pixels) {
     const struct animation_compose_config *config = dev->config;
     struct animation_compose_data *data           = dev->data;
     bool still_running                            = false;
+    cull_occluded(dev);
+    // later animations are composited over earlier ones
     for (int i = 0; i < config->num_animations; ++i) {
-        if (!animation_is_finished(config->animations[i])) {
-            animation_render_frame(config->animations[i], pixels, num_pixels);
-            // animation can finish by this rendering
-            still_running = !animation_is_finished(config->animations[i]);
+        if (animation_is_finished(config->animations[i])) {
+            continue;
+        }
+        if (!config->culled[i]) {
+            render_blended(dev, i, pixels, num_pixels);
         }
+        // animation can finish by this rendering
+        still_running |= !animation_is_finished(config->animations[i]);
     }
     if (!still_running) {
         // finished
-        int rc = k_mutex_lock(&data->mutex, K_FOREVER);
-        if (rc != 0) {
-            LOG_ERR("Failed to lock mutex: %d", rc);
-            return;
-        }
         data->running = false;
-        rc            = k_mutex_unlock(&data->mutex);
-        if (rc != 0) {
-            LOG_ERR("Failed to unlock mutex: %d", rc);
-            return;
-        }
+    }
+}
+
+/**
+ * Fit durations-ms into the requested duration. Truncating plays animations in
+ * order until the requested duration runs out, scaling stretches or shrinks
+ * all of them. In both cases no animation plays beyond the requested duration,
+ * including animations played until they finish.
+ */
+static void plan_timeline(const struct device *dev,
+                          uint32_t request_duration_ms) {
+    const struct animation_compose_config *config = dev->config;
+    struct animation_compose_data *data           = dev->data;
+    uint64_t total                                = 0;
+    for (int i = 0; i < config->num_animations; ++i) {
+        config->timeline[i] = config->durations[i];
+        total += config->durations[i];
+    }
+    if (request_duration_ms == 0 ||
+        request_duration_ms == ANIMATION_DURATION_FOREVER) {
+        data->budget_frames = ANIMATION_DURATION_FOREVER;
         return;
     }
+    data->budget_frames =
+        MAX(ANIMATION_DURATION_MS_TO_FRAMES(request_duration_ms), 1);
+    if (!config->scale_timeline || total == 0) {
+        return;
+    }
+    for (int i = 0; i < config->num_animations; ++i) {
+        // keep scaled animations in the timeline
+        config->timeline[i] =
+            MAX(config->durations[i] * (uint64_t)request_duration_ms / total,
+                config->durations[i] > 0);
+    }
 }
 
+static void start_sequential(const struct device *dev, int index) {
+    const struct animation_compose_config *config = dev->config;
+    struct animation_compose_data *data           = dev->data;
+    uint32_t duration                             = config->timeline[index];
+    uint32_t frames =
+        duration == 0 ? ANIMATION_DURATION_FOREVER
+                      : MAX(ANIMATION_DURATION_MS_TO_FRAMES(duration), 1);
+    if (frames > data->budget_frames) {
+        // cut by the rest of the requested duration
+        frames   = data->budget_frames;
+        duration = MAX(frames * 1000ULL / CONFIG_ZMK_ANIMATION_FPS, 1);
+    }
+    data->current_index = index;
+    data->frames_left   = frames;
+    zmk_animation_divider_reset(&config->dividers[index]);
+    animation_start_with_params(config->animations[index], duration,
+                                &data->params);
+}
+
+static void finish_sequential(const struct device *dev, int index) {
+    const struct animation_compose_config *config = dev->config;
+    struct animation_compose_data *data           = dev->data;
+    animation_stop(config->animations[index]);
+    data->running       = false;
+    data->current_index = 0;
+    LOG_DBG("all animations finished");
+}
+
+static inline uint32_t count_down(uint32_t frames, uint32_t step) {
+    if (frames == ANIMATION_DURATION_FOREVER) {
+        return frames;
+    }
+    return frames > step ? frames - step : 0;
+}
+
+/**
+ * The next animation is started at the beginning of the frame after its
+ * predecessor ended and renders in that frame, so no frame is left blank
+ * between them.
+ */
 void render_frame_for_sequential(const struct device *dev,
                                  struct animation_pixel *pixels,
                                  size_t num_pixels) {
     const struct animation_compose_config *config = dev->config;
     struct animation_compose_data *data           = dev->data;
     int current                                   = data->current_index;
-    animation_render_frame(config->animations[current], pixels, num_pixels);
-    if (animation_is_finished(config->animations[current])) {
-        int rc = k_mutex_lock(&data->mutex, K_FOREVER);
-        if (rc != 0) {
-            LOG_ERR("Failed to lock mutex: %d", rc);
-            return;
-        }
-        if (data->running && data->current_index == current) {
-            int next = current + 1;
-            if (next >= config->num_animations) {
-                data->running       = false;
-                data->current_index = 0;
-                LOG_DBG("all animations finished");
-            } else {
-                LOG_DBG("start next animation[%d]", next);
-                data->current_index = next;
-                // TODO: consider request_duration_ms (how?)
-                animation_start(config->animations[next],
-                                config->durations[next]);
-                // request frame to give chance to switch animation even if next
-                // animation is not started
-                zmk_animation_request_frames(1);
-            }
-        } else {
-            LOG_DBG("detect concurrent update");
-        }
-        rc = k_mutex_unlock(&data->mutex);
-        if (rc != 0) {
-            LOG_ERR("Failed to unlock mutex: %d", rc);
+    if (data->frames_left == 0 ||
+        animation_is_finished(config->animations[current])) {
+        // the last animation can be stopped from outside between frames
+        if (current + 1 >= config->num_animations ||
+            data->budget_frames == 0) {
+            finish_sequential(dev, current);
             return;
         }
+        animation_stop(config->animations[current]);
+        current++;
+        LOG_DBG("start next animation[%d]", current);
+        start_sequential(dev, current);
+    }
+
+    zmk_animation_render_divided(config->animations[current],
+                                 &config->dividers[current], pixels,
+                                 num_pixels);
+
+    uint32_t step       = zmk_animation_get_frame_step();
+    data->frames_left   = count_down(data->frames_left, step);
+    data->budget_frames = count_down(data->budget_frames, step);
+    if (data->frames_left > 0 &&
+        !animation_is_finished(config->animations[current])) {
+        return;
+    }
+    if (current + 1 >= config->num_animations || data->budget_frames == 0) {
+        finish_sequential(dev, current);
+    } else {
+        // request frame to switch animation even if the ended animation
+        // doesn't request more
+        zmk_animation_request_frames(1);
     }
 }
 
@@ -115,42 +361,43 @@ static void animation_compose_render_frame(const struct device *dev,
     }
 }
 
-static void animation_compose_start(const struct device *dev,
-                                    uint32_t request_duration_ms) {
+static void animation_compose_start_with_params(
+    const struct device *dev, uint32_t request_duration_ms,
+    const struct animation_params *params) {
     const struct animation_compose_config *config = dev->config;
     struct animation_compose_data *data           = dev->data;
     if (data->running) {
         LOG_INF("animation compose already running");
         return;
     }
-    int rc = k_mutex_lock(&data->mutex, K_FOREVER);
-    if (rc != 0) {
-        LOG_ERR("Failed to lock mutex: %d", rc);
+    const struct animation_params none = {};
+    data->params                       = params != NULL ? *params : none;
+
+    data->current_index = 0;
+    data->running       = true;
+    LOG_DBG("Start animation compose");
+    if (!config->parallel) {
+        plan_timeline(dev, request_duration_ms);
+        start_sequential(dev, 0);
+        zmk_animation_request_frames(1);
         return;
     }
-    if (!data->running) {
-        data->current_index = 0;
-        data->running       = true;
-        LOG_DBG("Start animation compose");
-        int ub = config->parallel ? config->num_animations : 1;
-
-        for (int i = 0; i < ub; ++i) {
-            uint32_t duration = config->durations[i];
-            // request_duration_ms is not respected for sequential animation
-            if (request_duration_ms > 0 && duration > request_duration_ms) {
-                duration = request_duration_ms;
-            }
-            animation_start(config->animations[i], duration);
+
+    for (int i = 0; i < config->num_animations; ++i) {
+        uint32_t duration = config->durations[i];
+        if (request_duration_ms > 0 && duration > request_duration_ms) {
+            duration = request_duration_ms;
         }
-        zmk_animation_request_frames(1);
-    } else {
-        LOG_INF("animation compose already running (after taking lock)");
-    }
-    rc = k_mutex_unlock(&data->mutex);
-    if (rc != 0) {
-        LOG_ERR("Failed to unlock mutex: %d", rc);
-        return;
+        zmk_animation_divider_reset(&config->dividers[i]);
+        animation_start_with_params(config->animations[i], duration,
+                                    &data->params);
     }
+    zmk_animation_request_frames(1);
+}
+
+static void animation_compose_start(const struct device *dev,
+                                    uint32_t request_duration_ms) {
+    animation_compose_start_with_params(dev, request_duration_ms, NULL);
 }
 
 static void animation_compose_stop(const struct device *dev) {
@@ -159,29 +406,17 @@ static void animation_compose_stop(const struct device *dev) {
     if (!data->running) {
         return;
     }
-    int rc = k_mutex_lock(&data->mutex, K_FOREVER);
-    if (rc != 0) {
-        LOG_ERR("Failed to lock mutex: %d", rc);
-        return;
-    }
-    if (data->running) {  // check again after taking the lock
-        if (config->parallel) {
-            for (int i = 0; i < config->num_animations; ++i) {
-                // Let's always stop for simplicity. The animation might be
-                // already stopped.
-                animation_stop(config->animations[i]);
-            }
-        } else {
-            animation_stop(config->animations[data->current_index]);
+    if (config->parallel) {
+        for (int i = 0; i < config->num_animations; ++i) {
+            // Let's always stop for simplicity. The animation might be
+            // already stopped.
+            animation_stop(config->animations[i]);
         }
+    } else {
+        animation_stop(config->animations[data->current_index]);
     }
     data->current_index = 0;
     data->running       = false;
-    rc                  = k_mutex_unlock(&data->mutex);
-    if (rc != 0) {
-        LOG_ERR("Failed to unlock mutex: %d", rc);
-        return;
-    }
     LOG_DBG("Stop animation compose");
 }
 
@@ -190,27 +425,164 @@ static bool animation_compose_is_finished(const struct device *dev) {
     return !data->running;
 }
 
-static int animation_compose_init(const struct device *dev) {
+static uint32_t gcd(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        uint32_t t = a % b;
+        a          = b;
+        b          = t;
+    }
+    return a;
+}
+
+static uint32_t animation_compose_get_period(const struct device *dev) {
+    const struct animation_compose_config *config = dev->config;
+    struct animation_compose_data *data           = dev->data;
+    if (!data->running || !config->parallel) {
+        return 0;
+    }
+    // least common multiple of all periods
+    uint32_t period = 1;
+    for (int i = 0; i < config->num_animations; ++i) {
+        if (animation_is_finished(config->animations[i])) {
+            continue;
+        }
+        uint32_t p = animation_get_period(config->animations[i]);
+        if (p == 0) {
+            return 0;
+        }
+        // divided animation repeats its frames at the divided rate
+        p *= config->dividers[i].divider;
+        period = period / gcd(period, p) * p;
+    }
+    return period;
+}
+
+/**
+ * Collect the union of pixel maps of all animations in ascending order.
+ * Called on first use because the animations can be defined after this.
+ */
+static void animation_compose_collect_pixel_map(const struct device *dev) {
+    const struct animation_compose_config *config = dev->config;
+    struct animation_compose_data *data           = dev->data;
+    uint8_t used[DIV_ROUND_UP(ZMK_ANIMATION_NUM_PIXELS, 8)] = {};
+
+    data->pixel_map_all  = false;
+    data->pixel_map_size = 0;
+    for (int i = 0; i < config->num_animations; ++i) {
+        const size_t *pixel_map;
+        size_t size =
+            animation_get_pixel_map(config->animations[i], &pixel_map);
+        if (pixel_map == NULL) {
+            data->pixel_map_all = true;
+            break;
+        }
+        for (size_t j = 0; j < size; ++j) {
+            used[pixel_map[j] / 8] |= BIT(pixel_map[j] % 8);
+        }
+    }
+    if (!data->pixel_map_all) {
+        for (size_t p = 0; p < ZMK_ANIMATION_NUM_PIXELS; ++p) {
+            if (used[p / 8] & BIT(p % 8)) {
+                config->pixel_map[data->pixel_map_size++] = p;
+            }
+        }
+    }
+    data->pixel_map_ready = true;
+}
+
+static size_t animation_compose_get_pixel_map(const struct device *dev,
+                                              const size_t **pixel_map) {
     const struct animation_compose_config *config = dev->config;
     struct animation_compose_data *data           = dev->data;
-    int rc                                        = k_mutex_init(&data->mutex);
-    if (rc != 0) {
-        LOG_ERR("Failed to initialize mutex: %d", rc);
-        return rc;
+    if (!data->pixel_map_ready) {
+        animation_compose_collect_pixel_map(dev);
+    }
+    *pixel_map = data->pixel_map_all ? NULL : config->pixel_map;
+    return data->pixel_map_all ? 0 : data->pixel_map_size;
+}
+
+static int animation_compose_init(const struct device *dev) {
+    const struct animation_compose_config *config = dev->config;
+    uint8_t held                                  = 0;
+    for (int i = 0; i < config->num_animations && held < config->num_held;
+         ++i) {
+        if (config->dividers[i].divider > 1) {
+            config->dividers[i].held = config->held[held++];
+        }
     }
     return 0;
 }
 
+static bool animation_compose_contains(const struct device *dev,
+                                       const struct device *animation) {
+    const struct animation_compose_config *config = dev->config;
+    for (int i = 0; i < config->num_animations; ++i) {
+        if (animation_contains(config->animations[i], animation)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool animation_compose_shares(const struct device *dev,
+                                     const struct device *animation) {
+    const struct animation_compose_config *config = dev->config;
+    if (animation_contains(animation, dev)) {
+        return true;
+    }
+    for (int i = 0; i < config->num_animations; ++i) {
+        if (animation_shares(config->animations[i], animation)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static const struct animation_api animation_compose_api = {
-    .on_start     = animation_compose_start,
-    .on_stop      = animation_compose_stop,
-    .render_frame = animation_compose_render_frame,
-    .is_finished  = animation_compose_is_finished,
+    .on_start             = animation_compose_start,
+    .on_stop              = animation_compose_stop,
+    .render_frame         = animation_compose_render_frame,
+    .is_finished          = animation_compose_is_finished,
+    .get_period           = animation_compose_get_period,
+    .get_pixel_map        = animation_compose_get_pixel_map,
+    .on_start_with_params = animation_compose_start_with_params,
+    .contains             = animation_compose_contains,
+    .shares               = animation_compose_shares,
 };
 
 #define PHANDLE_TO_DEVICE(node_id, prop, idx) \
     DEVICE_DT_GET(DT_PHANDLE_BY_IDX(node_id, prop, idx)),
 
+// frame-dividers of compose overrides frame-divider of the animation
+#define FRAME_DIVIDER(node_id, prop, idx)                               \
+    COND_CODE_1(                                                        \
+        CONFIG_ZMK_ANIMATION_FRAME_DIVIDERS,                            \
+        (COND_CODE_1(DT_NODE_HAS_PROP(node_id, frame_dividers),         \
+                     (DT_PROP_BY_IDX(node_id, frame_dividers, idx)),    \
+                     (DT_PROP_OR(DT_PHANDLE_BY_IDX(node_id, prop, idx), \
+                                 frame_divider, 1)))),                  \
+        (1))
+
+#define PHANDLE_TO_DIVIDER(node_id, prop, idx) \
+    {.divider = FRAME_DIVIDER(node_id, prop, idx)},
+
+#define PHANDLE_TO_HELD_COUNT(node_id, prop, idx) \
+    +(FRAME_DIVIDER(node_id, prop, idx) > 1)
+
+#define PHANDLE_TO_BLENDING_MODE(node_id, prop, idx)                     \
+    DT_ENUM_IDX_OR(DT_PHANDLE_BY_IDX(node_id, prop, idx), blending_mode, \
+                   ZMK_ANIMATION_BLENDING_MODE_NORMAL),
+
+#define PHANDLE_TO_OPACITY(node_id, prop, idx)        \
+    COND_CODE_1(DT_NODE_HAS_PROP(node_id, opacities), \
+                (DT_PROP_BY_IDX(node_id, opacities, idx)), (255)),
+
+// buffers used only by parallel or sequential compose
+#define COMPOSE_PARALLEL_SIZE(idx, size) \
+    (DT_INST_PROP(idx, parallel) ? (size) : 0)
+#define COMPOSE_SEQUENTIAL_SIZE(idx, size) \
+    (DT_INST_PROP(idx, parallel) ? 0 : (size))
+
 #define ANIMATION_COMPOSE_DEVICE(idx)                                         \
                                                                               \
     static struct animation_compose_data animation_compose_##idx##_data;      \
@@ -219,13 +591,42 @@ static const struct animation_api animation_compose_api = {
         DT_INST_FOREACH_PROP_ELEM(idx, animations, PHANDLE_TO_DEVICE)};       \
     static const uint32_t animation_compose_##idx##_durations[] =             \
         DT_INST_PROP(idx, durations_ms);                                      \
+    static struct zmk_animation_divider                                       \
+        animation_compose_##idx##_dividers[] = {                              \
+            DT_INST_FOREACH_PROP_ELEM(idx, animations, PHANDLE_TO_DIVIDER)};  \
+    static struct zmk_color_rgb animation_compose_##idx##_held                \
+        [0 DT_INST_FOREACH_PROP_ELEM(idx, animations, PHANDLE_TO_HELD_COUNT)] \
+        [ZMK_ANIMATION_NUM_PIXELS];                                           \
+    static size_t                                                             \
+        animation_compose_##idx##_pixel_map[ZMK_ANIMATION_NUM_PIXELS];        \
+    static const uint8_t animation_compose_##idx##_blending_modes[] = {       \
+        DT_INST_FOREACH_PROP_ELEM(idx, animations,                            \
+                                  PHANDLE_TO_BLENDING_MODE)};                 \
+    static const uint8_t animation_compose_##idx##_opacities[] = {            \
+        DT_INST_FOREACH_PROP_ELEM(idx, animations, PHANDLE_TO_OPACITY)};      \
+    static bool animation_compose_##idx##_culled[COMPOSE_PARALLEL_SIZE(       \
+        idx, DT_INST_PROP_LEN(idx, animations))];                             \
+    static struct zmk_color_rgb animation_compose_##idx##_under               \
+        [COMPOSE_PARALLEL_SIZE(idx, ZMK_ANIMATION_NUM_PIXELS)];               \
+    static uint32_t animation_compose_##idx##_timeline                        \
+        [COMPOSE_SEQUENTIAL_SIZE(idx, DT_INST_PROP_LEN(idx, animations))];    \
                                                                               \
     static struct animation_compose_config animation_compose_##idx##_config = \
         {                                                                     \
             .animations     = &animation_compose_##idx##_animations[0],       \
             .durations      = &animation_compose_##idx##_durations[0],        \
+            .dividers       = &animation_compose_##idx##_dividers[0],         \
             .num_animations = DT_INST_PROP_LEN(idx, animations),              \
             .parallel       = DT_INST_PROP(idx, parallel),                    \
+            .held           = animation_compose_##idx##_held,                 \
+            .num_held       = ARRAY_SIZE(animation_compose_##idx##_held),     \
+            .pixel_map      = &animation_compose_##idx##_pixel_map[0],        \
+            .blending_modes = animation_compose_##idx##_blending_modes,       \
+            .opacities      = animation_compose_##idx##_opacities,            \
+            .culled         = animation_compose_##idx##_culled,               \
+            .under          = animation_compose_##idx##_under,                \
+            .timeline       = animation_compose_##idx##_timeline,             \
+            .scale_timeline = DT_INST_ENUM_IDX(idx, duration_fit) == 1,       \
     };                                                                        \
                                                                               \
     DEVICE_DT_INST_DEFINE(                                                    \
@@ -6,17 +6,21 @@
 
 #define DT_DRV_COMPAT zmk_animation_control
 
+#include <math.h>
 #include <stdio.h>
 #include <zephyr/device.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/settings/settings.h>
 #include <zephyr/types.h>
+#include <zmk/battery.h>
 #include <zmk/event_manager.h>
 #include <zmk/events/usb_conn_state_changed.h>
 #include <zmk/events/activity_state_changed.h>
+#include <zmk/events/battery_state_changed.h>
 #include <zmk/usb.h>
 #include <zmk_driver_animation/animation.h>
+#include <zmk_driver_animation/color.h>
 #include <zmk_driver_animation/drivers/animation.h>
 #include <zmk_driver_animation/drivers/animation_control.h>
 #include <drivers/ext_power.h>
@@ -30,12 +34,87 @@ struct animation_queue_record {
     const struct device *animation;
     bool cancelable;
     uint32_t duration_ms;
+    uint8_t priority;
+    // uptime in ms after which the record is dropped unplayed, 0 never
+    int64_t expires_at;
+    // handle returned to the caller, 0 for animations of the power state
+    int handle;
+    // given to the animation on start without copying
+    struct animation_params params;
 };
 
+/**
+ * Handle of an ad-hoc animation. The handle encodes the slot index in the
+ * low byte and the slot generation above it, so a handle of a reused slot
+ * doesn't match.
+ */
+struct animation_handle_slot {
+    enum animation_control_handle_state state;
+    // 1 to 255, incremented each time the slot is allocated
+    uint8_t generation;
+    // canceled records are dropped from the queue or stopped on next frame
+    bool canceled;
+    // extended while playing, the animation is restarted if it finishes
+    // before ends_at
+    bool extended;
+    // duration added while queued
+    uint32_t extended_ms;
+    // uptime in ms when the playing animation ends, 0 if it plays until it
+    // finishes
+    int64_t ends_at;
+};
+
+#define HANDLE_SLOT_INDEX(handle) ((handle) & 0xff)
+#define HANDLE_GENERATION(handle) ((handle) >> 8)
+
+/**
+ * Queue of ad-hoc animations ordered by priority, FIFO among the same
+ * priority. Records are pushed from any context and popped by the render
+ * path.
+ */
 struct animation_queue {
-    struct k_msgq que;
-    char *que_buffer;
-    size_t que_buffer_size;
+    struct animation_queue_record *records;
+    size_t capacity;
+    size_t size;
+    // handles of queued, pending play-now and playing records
+    struct animation_handle_slot *slots;
+    size_t num_slots;
+    struct k_spinlock lock;
+};
+
+enum animation_control_command_type {
+    ANIMATION_CONTROL_COMMAND_PLAY_NOW,
+    ANIMATION_CONTROL_COMMAND_PLAY_OVERLAY,
+    ANIMATION_CONTROL_COMMAND_STOP_ANIMATION,
+    ANIMATION_CONTROL_COMMAND_SET_ENABLED,
+    ANIMATION_CONTROL_COMMAND_SET_NEXT_ANIMATION,
+    ANIMATION_CONTROL_COMMAND_SET_ANIMATION,
+    ANIMATION_CONTROL_COMMAND_CHANGE_BRIGHTNESS,
+    ANIMATION_CONTROL_COMMAND_SET_FRAME_DIVIDER,
+    ANIMATION_CONTROL_COMMAND_POWER_SOURCE_CHANGED,
+    ANIMATION_CONTROL_COMMAND_BATTERY_CHANGED,
+};
+
+/**
+ * State change requested from any context. Commands are applied in order at
+ * the beginning of the next frame, so the state is only mutated by the render
+ * path and needs no lock.
+ */
+struct animation_control_command {
+    enum animation_control_command_type type;
+    // PLAY_NOW, PLAY_OVERLAY: animation to play,
+    // STOP_ANIMATION: animation to stop
+    struct animation_queue_record record;
+    // SET_ENABLED: enabled, SET_NEXT_ANIMATION: index offset,
+    // SET_ANIMATION: index, CHANGE_BRIGHTNESS: brightness offset,
+    // SET_FRAME_DIVIDER: divider
+    int value;
+    enum animation_control_power_source power_source;
+};
+
+struct animation_control_frame_divider {
+    const struct device *animation;
+    uint8_t divider;
 };
 
 struct animation_control_work_context {
@@ -43,6 +122,7 @@ struct animation_control_work_context {
     const struct device *animation;
     struct k_work_delayable save_work;
     struct k_work_delayable init_animation_work;
+    struct k_work_delayable power_off_work;
 };
 
 struct animation_control_config {
@@ -58,11 +138,36 @@ struct animation_control_config {
     const struct device *activation_animation;
     const uint32_t activation_animation_duration_ms;
     const struct device *ext_power;
+    const uint32_t ext_power_settle_ms;
+    const uint32_t ext_power_off_delay_ms;
+    const uint16_t power_off_black_frames;
     const uint8_t brightness_steps;
     const uint8_t max_brightness;
+    const bool brightness_curve_cie;
+    const uint16_t brightness_ramp_frames;
+    // multiplier of each brightness step, computed on init
+    float *brightness_levels;
+    // animations played on top of the base animation, ascending priority
+    struct animation_queue_record *overlays;
+    const uint8_t overlay_slots;
+    const uint16_t crossfade_frames;
+    // frame of the outgoing animation and the union of pixel maps of the
+    // outgoing and incoming animations, ZMK_ANIMATION_NUM_PIXELS entries
+    struct zmk_color_rgb *fade_buffer;
+    size_t *fade_pixel_map;
+    // frame rate dividers applied unless overridden by the user
+    const uint8_t battery_frame_divider;
+    const uint8_t low_battery_frame_divider;
+    const uint8_t low_battery_threshold;
     const struct animation_control_work_context *work;
     const struct settings_handler *settings_handler;
-    const struct animation_queue *que;
+    struct animation_queue *que;
+    // expiry of records queued by enqueue_animation
+    const uint32_t queue_expiry_ms;
+    struct k_msgq *commands;
+    // animations with frame-divider larger than 1
+    const struct animation_control_frame_divider *frame_dividers;
+    const size_t frame_dividers_size;
 };
 
 struct animation_control_save_data {
@@ -75,20 +180,50 @@ struct animation_control_save_data {
 
 struct animation_control_data {
     struct animation_control_save_data s;
+    // Fields below are mutated only in the render context, i.e. render_frame,
+    // commands applied by it and start/stop called by the parent animation.
     // `running` is true if animation started
     // if false, `running_animation.animation` is ensured to be null
     // even if true, `running_animation.animation` can be null
     // this value should be mutated only in start/stop method
     bool running;
     struct animation_queue_record running_animation;
-    // mutex for updating `running_animation`
-    struct k_mutex mutex;
     // internal flag to notify to check next animation if current animation is
     // cancelable
     bool change_animation_if_cancelable;
     // power status cache
     bool last_powered;
     bool playing_adhoc_animation;
+    // frame divider of `running_animation.animation`
+    struct zmk_animation_divider divider;
+    // true if power is off because frames are black
+    bool power_gated;
+    // power state requested by request_power() and actual rail state
+    bool power_requested;
+    bool power_on;
+    // multiplier applied to frames, ramped from `brightness_from` to
+    // `brightness_to` while `brightness_ramp_left` > 0
+    float brightness;
+    float brightness_from;
+    float brightness_to;
+    uint16_t brightness_ramp_left;
+    // stop after ramping brightness down to 0
+    bool stop_after_ramp;
+    // number of playing `config->overlays`
+    uint8_t num_overlays;
+    // outgoing animation rendered with `running_animation.animation` while
+    // `fade_left` > 0
+    const struct device *fade_from;
+    uint16_t fade_left;
+    // true if either animation can render to any pixel
+    bool fade_all;
+    size_t fade_pixel_map_size;
+    // number of times power turned on in the current hour
+    uint16_t power_toggles;
+    int64_t power_toggles_since;
+    // frame rate divider set by the user, 0 follows the power source policy.
+    // saved separately from `s` to keep its settings compatible
+    uint8_t frame_divider;
 };
 
 static int animation_control_load_settings(const struct device *dev,
@@ -119,6 +254,14 @@ static int animation_control_load_settings(const struct device *dev,
 
         return rc;
     }
+    if (settings_name_steq(name, "rate", &next) && !next) {
+        struct animation_control_data *data = dev->data;
+        if (len != sizeof(data->frame_divider)) {
+            return -EINVAL;
+        }
+        rc = read_cb(cb_arg, &data->frame_divider, sizeof(data->frame_divider));
+        return rc >= 0 ? 0 : rc;
+    }
 
     return -ENOENT;
 #else
@@ -138,6 +281,8 @@ static void animation_control_save_work(struct k_work *work) {
     struct animation_control_data *data = dev->data;
     settings_save_one(path, &data->s,
                       sizeof(struct animation_control_save_data));
+    snprintf(path, 40, "%s/rate", dev->name);
+    settings_save_one(path, &data->frame_divider, sizeof(data->frame_divider));
 };
 
 static int animation_control_save_settings(const struct device *dev) {
@@ -151,6 +296,259 @@ static int animation_control_save_settings(const struct device *dev) {
 }
 #endif /* IS_ENABLED(CONFIG_SETTINGS) */
 
+/**
+ * Allocate a handle slot. Caller must hold the lock.
+ * @return handle, or 0 if all slots are in use
+ */
+static int animation_handle_alloc(struct animation_queue *que) {
+    for (size_t i = 0; i < que->num_slots; ++i) {
+        struct animation_handle_slot *slot = &que->slots[i];
+        if (slot->state != ANIMATION_CONTROL_HANDLE_DONE) {
+            continue;
+        }
+        slot->generation =
+            slot->generation == UINT8_MAX ? 1 : slot->generation + 1;
+        slot->state       = ANIMATION_CONTROL_HANDLE_QUEUED;
+        slot->canceled    = false;
+        slot->extended    = false;
+        slot->extended_ms = 0;
+        slot->ends_at     = 0;
+        return slot->generation << 8 | i;
+    }
+    return 0;
+}
+
+/**
+ * Find the slot of the handle. Caller must hold the lock.
+ * @return NULL if the handle is done or invalid
+ */
+static struct animation_handle_slot *animation_handle_get(
+    struct animation_queue *que, int handle) {
+    if (handle <= 0 || HANDLE_SLOT_INDEX(handle) >= que->num_slots) {
+        return NULL;
+    }
+    struct animation_handle_slot *slot = &que->slots[HANDLE_SLOT_INDEX(handle)];
+    if (slot->state == ANIMATION_CONTROL_HANDLE_DONE ||
+        slot->generation != HANDLE_GENERATION(handle)) {
+        return NULL;
+    }
+    return slot;
+}
+
+/**
+ * Release the handle. Caller must hold the lock.
+ */
+static void animation_handle_free(struct animation_queue *que, int handle) {
+    struct animation_handle_slot *slot = animation_handle_get(que, handle);
+    if (slot != NULL) {
+        slot->state = ANIMATION_CONTROL_HANDLE_DONE;
+    }
+}
+
+/**
+ * Mark the handle of the record as playing and add the duration extended
+ * while queued. Caller must hold the lock.
+ * @return false if the handle was canceled before it started
+ */
+static bool animation_handle_play(struct animation_queue *que,
+                                  struct animation_queue_record *record) {
+    if (record->handle == 0) {
+        return true;
+    }
+    struct animation_handle_slot *slot =
+        animation_handle_get(que, record->handle);
+    if (slot == NULL) {
+        return false;
+    }
+    if (slot->canceled) {
+        slot->state = ANIMATION_CONTROL_HANDLE_DONE;
+        return false;
+    }
+    slot->state = ANIMATION_CONTROL_HANDLE_PLAYING;
+    if (record->duration_ms != 0 &&
+        record->duration_ms != ANIMATION_DURATION_FOREVER) {
+        record->duration_ms += slot->extended_ms;
+        slot->ends_at = k_uptime_get() + record->duration_ms;
+    }
+    return true;
+}
+
+/**
+ * Drop expired and canceled records. Caller must hold the lock.
+ * @return number of dropped records
+ */
+static size_t animation_queue_drop_stale(struct animation_queue *que) {
+    const int64_t now = k_uptime_get();
+    size_t size       = 0;
+    for (size_t i = 0; i < que->size; ++i) {
+        const struct animation_queue_record *record = &que->records[i];
+        const struct animation_handle_slot *slot =
+            animation_handle_get(que, record->handle);
+        if ((record->expires_at == 0 || now < record->expires_at) &&
+            (slot == NULL || !slot->canceled)) {
+            que->records[size++] = *record;
+        } else {
+            animation_handle_free(que, record->handle);
+        }
+    }
+    size_t dropped = que->size - size;
+    que->size      = size;
+    return dropped;
+}
+
+/**
+ * Insert the record after queued records with the same or higher priority.
+ * Caller must hold the lock and ensure the queue has room.
+ */
+static void animation_queue_insert(
+    struct animation_queue *que, const struct animation_queue_record *record) {
+    size_t pos = que->size;
+    while (pos > 0 && que->records[pos - 1].priority < record->priority) {
+        que->records[pos] = que->records[pos - 1];
+        pos--;
+    }
+    que->records[pos] = *record;
+    que->size++;
+}
+
+static void animation_queue_remove(struct animation_queue *que, size_t index) {
+    for (size_t i = index + 1; i < que->size; ++i) {
+        que->records[i - 1] = que->records[i];
+    }
+    que->size--;
+}
+
+/**
+ * Push the record. A queued record of the same animation is merged with it,
+ * keeping the higher priority, the longer duration and the later expiry.
+ * If the queue is full, the newest record of the lowest priority is dropped
+ * for a record with higher priority.
+ * @return handle of the queued record, or -ENOMEM
+ */
+static int animation_queue_push(struct animation_queue *que,
+                                const struct animation_queue_record *record) {
+    int rc               = -ENOMEM;
+    k_spinlock_key_t key = k_spin_lock(&que->lock);
+    size_t dropped       = animation_queue_drop_stale(que);
+
+    size_t i = 0;
+    while (i < que->size && que->records[i].animation != record->animation) {
+        i++;
+    }
+    if (i < que->size) {
+        struct animation_queue_record *queued = &que->records[i];
+        struct animation_queue_record merged  = *queued;
+        merged.cancelable = queued->cancelable && record->cancelable;
+        merged.priority   = MAX(queued->priority, record->priority);
+        merged.params     = record->params;
+        // 0 plays until the animation finishes
+        merged.duration_ms =
+            queued->duration_ms == 0 || record->duration_ms == 0
+                ? 0
+                : MAX(queued->duration_ms, record->duration_ms);
+        merged.expires_at = queued->expires_at == 0 || record->expires_at == 0
+                                ? 0
+                                : MAX(queued->expires_at, record->expires_at);
+        if (merged.priority == queued->priority) {
+            *queued = merged;
+        } else {
+            animation_queue_remove(que, i);
+            animation_queue_insert(que, &merged);
+        }
+        rc = merged.handle;
+    } else if (que->size < que->capacity ||
+               que->records[que->size - 1].priority < record->priority) {
+        if (que->size == que->capacity) {
+            que->size--;
+            dropped++;
+            animation_handle_free(que, que->records[que->size].handle);
+        }
+        struct animation_queue_record pushed = *record;
+        // a slot is freed above if the queue was full. Slots are also held by
+        // pending commands and playing records, which can use them all.
+        pushed.handle = animation_handle_alloc(que);
+        if (pushed.handle != 0) {
+            animation_queue_insert(que, &pushed);
+            rc = pushed.handle;
+        }
+    }
+
+    k_spin_unlock(&que->lock, key);
+    if (dropped > 0) {
+        LOG_DBG("Dropped %zu queued animations", dropped);
+    }
+    return rc;
+}
+
+/**
+ * Pop the record with the highest priority.
+ * @return false if no record is queued
+ */
+static bool animation_queue_pop(struct animation_queue *que,
+                                struct animation_queue_record *record) {
+    k_spinlock_key_t key = k_spin_lock(&que->lock);
+    animation_queue_drop_stale(que);
+    bool found = que->size > 0;
+    if (found) {
+        *record = que->records[0];
+        animation_queue_remove(que, 0);
+        // canceled records are already dropped
+        animation_handle_play(que, record);
+    }
+    k_spin_unlock(&que->lock, key);
+    return found;
+}
+
+static bool animation_queue_is_empty(struct animation_queue *que) {
+    k_spinlock_key_t key = k_spin_lock(&que->lock);
+    animation_queue_drop_stale(que);
+    bool empty = que->size == 0;
+    k_spin_unlock(&que->lock, key);
+    return empty;
+}
+
+/**
+ * Mark the handle as playing for a record given to play-now.
+ * @return false if the handle was canceled before it started
+ */
+static bool animation_handle_start(struct animation_queue *que,
+                                   struct animation_queue_record *record) {
+    k_spinlock_key_t key = k_spin_lock(&que->lock);
+    bool started         = animation_handle_play(que, record);
+    k_spin_unlock(&que->lock, key);
+    return started;
+}
+
+static void animation_handle_finish(struct animation_queue *que, int handle) {
+    k_spinlock_key_t key = k_spin_lock(&que->lock);
+    animation_handle_free(que, handle);
+    k_spin_unlock(&que->lock, key);
+}
+
+static bool animation_handle_is_canceled(struct animation_queue *que,
+                                         int handle) {
+    k_spinlock_key_t key               = k_spin_lock(&que->lock);
+    struct animation_handle_slot *slot = animation_handle_get(que, handle);
+    bool canceled                      = slot != NULL && slot->canceled;
+    k_spin_unlock(&que->lock, key);
+    return canceled;
+}
+
+/**
+ * @return milliseconds left of the duration extended while playing, 0 if not
+ * extended or already passed
+ */
+static uint32_t animation_handle_extended_ms(struct animation_queue *que,
+                                             int handle) {
+    k_spinlock_key_t key               = k_spin_lock(&que->lock);
+    struct animation_handle_slot *slot = animation_handle_get(que, handle);
+    int64_t left                       = slot != NULL && slot->extended
+                                             ? slot->ends_at - k_uptime_get()
+                                             : 0;
+    k_spin_unlock(&que->lock, key);
+    return left > 0 ? left : 0;
+}
+
 bool is_powered() {
     switch (zmk_usb_get_conn_state()) {
         case ZMK_USB_CONN_HID:
@@ -172,22 +570,6 @@ const struct device *get_animation_for_current_power_state(
     }
 }
 
-int lock_for_updating_animation(struct animation_control_data *data) {
-    int rc = k_mutex_lock(&data->mutex, K_FOREVER);
-    if (rc != 0) {
-        LOG_ERR("Failed to lock mutex: %d", rc);
-    }
-    return rc;
-}
-
-int unlock_after_updating_animation(struct animation_control_data *data) {
-    int rc = k_mutex_unlock(&data->mutex);
-    if (rc != 0) {
-        LOG_ERR("Failed to unlock mutex: %d", rc);
-    }
-    return rc;
-}
-
 int set_power(const struct animation_control_config *config, bool enable) {
     if (device_is_ready(config->ext_power)) {
         int rc = enable ? ext_power_enable(config->ext_power)
@@ -201,6 +583,322 @@ int set_power(const struct animation_control_config *config, bool enable) {
     return 0;
 }
 
+uint8_t get_frame_divider(const struct device *dev,
+                          const struct device *animation) {
+    const struct animation_control_config *config = dev->config;
+    for (size_t i = 0; i < config->frame_dividers_size; i++) {
+        if (config->frame_dividers[i].animation == animation) {
+            return config->frame_dividers[i].divider;
+        }
+    }
+    return 1;
+}
+
+static void count_power_toggle(const struct device *dev) {
+    struct animation_control_data *data = dev->data;
+    int64_t now                         = k_uptime_get();
+    if (now - data->power_toggles_since >= 3600 * MSEC_PER_SEC) {
+        if (data->power_toggles > 0) {
+            LOG_INF("LED power turned on %d times in the last hour",
+                    data->power_toggles);
+        }
+        data->power_toggles       = 0;
+        data->power_toggles_since = now;
+    }
+    data->power_toggles++;
+    LOG_DBG("LED power turned on %d times in this hour", data->power_toggles);
+}
+
+/**
+ * Turn power on now, or off after ext-power-off-delay-ms unless power is
+ * requested again meanwhile. Output is delayed by ext-power-settle-ms after
+ * turning power on so the first frame reaches LEDs on a stable rail.
+ */
+static void request_power(const struct device *dev, bool enable) {
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+    data->power_requested                         = enable;
+    if (!enable) {
+        if (data->power_on) {
+            // no-op if already scheduled
+            k_work_schedule(&config->work->power_off_work,
+                            K_MSEC(config->ext_power_off_delay_ms));
+        }
+        return;
+    }
+    k_work_cancel_delayable(&config->work->power_off_work);
+    if (data->power_on) {
+        return;
+    }
+    if (set_power(config, true) != 0) {
+        return;
+    }
+    data->power_on = true;
+    if (config->ext_power != NULL) {
+        count_power_toggle(dev);
+        zmk_animation_delay_output(config->ext_power_settle_ms);
+    }
+}
+
+static void animation_control_power_off_work(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct animation_control_work_context *ctx = CONTAINER_OF(
+        dwork, struct animation_control_work_context, power_off_work);
+    const struct device *dev                      = ctx->animation;
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+    if (data->power_requested || !data->power_on) {
+        return;
+    }
+    if (set_power(config, false) == 0) {
+        data->power_on = false;
+    }
+}
+
+static float get_target_brightness(const struct device *dev) {
+    const struct animation_control_config *config = dev->config;
+    const struct animation_control_data *data     = dev->data;
+    uint8_t brightness = data->last_powered ? data->s.powered_brightness
+                                            : data->s.battery_brightness;
+    return config->brightness_levels[MIN(brightness, config->brightness_steps)];
+}
+
+/**
+ * Ramp the brightness multiplier to `to` over brightness-ramp-ms.
+ */
+static void ramp_brightness(const struct device *dev, float to) {
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+
+    data->brightness_from      = data->brightness;
+    data->brightness_to        = to;
+    data->brightness_ramp_left = config->brightness_ramp_frames;
+    if (data->brightness_ramp_left == 0) {
+        data->brightness = to;
+    }
+    zmk_animation_invalidate_frame_cache();
+    zmk_animation_request_frames(1);
+}
+
+/**
+ * Advance the brightness ramp by a frame.
+ */
+static void step_brightness_ramp(const struct device *dev) {
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+    if (data->brightness_ramp_left == 0) {
+        return;
+    }
+    uint32_t step              = zmk_animation_get_frame_step();
+    data->brightness_ramp_left = data->brightness_ramp_left > step
+                                     ? data->brightness_ramp_left - step
+                                     : 0;
+    float progress = 1.0f - (float)data->brightness_ramp_left /
+                                config->brightness_ramp_frames;
+    data->brightness =
+        data->brightness_from +
+        (data->brightness_to - data->brightness_from) * progress;
+    // frames are requested only while the ramp runs
+    zmk_animation_request_frames(1);
+}
+
+/**
+ * Apply the frame rate divider set by the user, or the one for the current
+ * power source and battery level.
+ */
+static void apply_frame_rate(const struct device *dev) {
+    const struct animation_control_config *config = dev->config;
+    const struct animation_control_data *data     = dev->data;
+    uint8_t divider                               = data->frame_divider;
+    if (divider == 0) {
+        divider = data->last_powered ? 1 : config->battery_frame_divider;
+#if IS_ENABLED(CONFIG_ZMK_BATTERY_REPORTING)
+        if (!data->last_powered &&
+            zmk_battery_state_of_charge() < config->low_battery_threshold) {
+            divider = config->low_battery_frame_divider;
+        }
+#endif
+    }
+    zmk_animation_set_rate_divider(divider);
+}
+
+/**
+ * Stop after ramping the brightness down to 0.
+ */
+static void fade_out_and_stop(const struct device *dev) {
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+    // the ramp is stepped only while an animation renders, and there's
+    // nothing to fade out otherwise
+    if (config->brightness_ramp_frames == 0 || !data->running ||
+        data->running_animation.animation == NULL) {
+        animation_stop(dev);
+        return;
+    }
+    data->stop_after_ramp = true;
+    ramp_brightness(dev, 0);
+}
+
+/**
+ * Stop the outgoing animation of the crossfade.
+ */
+static void stop_crossfade(const struct device *dev) {
+    struct animation_control_data *data = dev->data;
+    if (data->fade_from == NULL) {
+        return;
+    }
+    animation_stop(data->fade_from);
+    data->fade_from = NULL;
+    data->fade_left = 0;
+}
+
+/**
+ * Keep `from` running to fade it out while `to` starts. Only the union of
+ * pixel maps of both animations is blended.
+ */
+static void start_crossfade(const struct device *dev,
+                            const struct device *from,
+                            const struct device *to) {
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+    const struct device *animations[] = {from, to};
+    uint8_t used[DIV_ROUND_UP(ZMK_ANIMATION_NUM_PIXELS, 8)] = {};
+
+    data->fade_all            = false;
+    data->fade_pixel_map_size = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(animations) && !data->fade_all; ++i) {
+        const size_t *pixel_map;
+        size_t size    = animation_get_pixel_map(animations[i], &pixel_map);
+        data->fade_all = pixel_map == NULL;
+        for (size_t j = 0; j < size; ++j) {
+            used[pixel_map[j] / 8] |= BIT(pixel_map[j] % 8);
+        }
+    }
+    if (!data->fade_all) {
+        for (size_t p = 0; p < ZMK_ANIMATION_NUM_PIXELS; ++p) {
+            if (used[p / 8] & BIT(p % 8)) {
+                config->fade_pixel_map[data->fade_pixel_map_size++] = p;
+            }
+        }
+    }
+    data->fade_from = from;
+    data->fade_left = config->crossfade_frames;
+}
+
+/**
+ * Render both animations of the crossfade and blend them with an integer
+ * alpha ramp. The frame is black before rendering since animation control is
+ * the root animation.
+ */
+static void render_crossfade(const struct device *dev,
+                             struct animation_pixel *pixels,
+                             size_t num_pixels) {
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+    const struct zmk_color_rgb black              = {};
+    const size_t size = data->fade_all ? num_pixels : data->fade_pixel_map_size;
+
+    animation_render_frame(data->fade_from, pixels, num_pixels);
+    for (size_t i = 0; i < size; ++i) {
+        size_t pixel = data->fade_all ? i : config->fade_pixel_map[i];
+        config->fade_buffer[i] = pixels[pixel].value;
+        pixels[pixel].value    = black;
+    }
+
+    zmk_animation_render_divided(data->running_animation.animation,
+                                 &data->divider, pixels, num_pixels);
+
+    uint32_t step   = zmk_animation_get_frame_step();
+    data->fade_left = data->fade_left > step ? data->fade_left - step : 0;
+    // weight of the incoming animation in 1/256
+    uint32_t alpha = 256 - 256 * data->fade_left / config->crossfade_frames;
+    for (size_t i = 0; i < size; ++i) {
+        size_t pixel = data->fade_all ? i : config->fade_pixel_map[i];
+        const struct zmk_color_rgb from = config->fade_buffer[i];
+        struct zmk_color_rgb *to        = &pixels[pixel].value;
+        to->r = from.r + (to->r - from.r) * alpha / 256;
+        to->g = from.g + (to->g - from.g) * alpha / 256;
+        to->b = from.b + (to->b - from.b) * alpha / 256;
+    }
+
+    if (data->fade_left == 0) {
+        LOG_DBG("crossfade finished");
+        stop_crossfade(dev);
+    } else {
+        // the fade runs at full frame rate even if both animations are static
+        zmk_animation_request_frames(1);
+    }
+}
+
+/**
+ * Start the finished animation again for the rest of the duration extended
+ * by its handle.
+ * @return true if restarted
+ */
+static bool restart_if_extended(const struct device *dev,
+                                const struct animation_queue_record *record) {
+    const struct animation_control_config *config = dev->config;
+    uint32_t extended_ms =
+        animation_handle_extended_ms(config->que, record->handle);
+    if (extended_ms == 0) {
+        return false;
+    }
+    LOG_DBG("restart %s for extended %d ms", record->animation->name,
+            extended_ms);
+    animation_stop(record->animation);
+    animation_start_with_params(record->animation, extended_ms,
+                                &record->params);
+    zmk_animation_invalidate_frame_cache();
+    zmk_animation_request_frames(1);
+    return true;
+}
+
+static void remove_overlay(const struct device *dev, size_t index) {
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+    const struct animation_queue_record *overlay  = &config->overlays[index];
+    LOG_DBG("Remove overlay %s", overlay->animation->name);
+    animation_stop(overlay->animation);
+    animation_handle_finish(config->que, overlay->handle);
+    for (size_t i = index + 1; i < data->num_overlays; ++i) {
+        config->overlays[i - 1] = config->overlays[i];
+    }
+    data->num_overlays--;
+    zmk_animation_invalidate_frame_cache();
+    zmk_animation_request_frames(1);
+}
+
+static void remove_overlays(const struct device *dev) {
+    struct animation_control_data *data = dev->data;
+    while (data->num_overlays > 0) {
+        remove_overlay(dev, data->num_overlays - 1);
+    }
+}
+
+/**
+ * Render overlays on top of the base animation in ascending priority. Each
+ * overlay overwrites only the pixels it renders to, and finishes
+ * independently.
+ */
+static void render_overlays(const struct device *dev,
+                            struct animation_pixel *pixels,
+                            size_t num_pixels) {
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+    size_t i                                      = 0;
+    while (i < data->num_overlays) {
+        const struct animation_queue_record *overlay = &config->overlays[i];
+        if (animation_handle_is_canceled(config->que, overlay->handle) ||
+            (animation_is_finished(overlay->animation) &&
+             !restart_if_extended(dev, overlay))) {
+            remove_overlay(dev, i);
+            continue;
+        }
+        animation_render_frame(overlay->animation, pixels, num_pixels);
+        i++;
+    }
+}
+
 /**
  * Change animation if next animation exists or next_animation_optional given.
  * Next animation is decided in below order:
@@ -224,7 +922,11 @@ void change_animation(
         return;
     }
     data->change_animation_if_cancelable = false;
-    data->last_powered                   = is_powered();
+    if (data->last_powered != is_powered()) {
+        data->last_powered = !data->last_powered;
+        ramp_brightness(dev, get_target_brightness(dev));
+        apply_frame_rate(dev);
+    }
 
     struct animation_queue_record current = data->running_animation;
     struct animation_queue_record next    = {};
@@ -238,12 +940,7 @@ void change_animation(
             zmk_animation_request_frames(1);
         }
         data->playing_adhoc_animation = true;
-    } else if (k_msgq_num_used_get(&config->que->que) > 0) {
-        int rc = k_msgq_get(&config->que->que, &next, K_NO_WAIT);
-        if (rc != 0) {
-            LOG_ERR("Failed to get next animation from queue: %d", rc);
-            return;
-        }
+    } else if (animation_queue_pop(config->que, &next)) {
         if (device_is_ready(next.animation)) {
             LOG_DBG("Got animation %s from queue", next.animation->name);
         } else {
@@ -265,45 +962,57 @@ void change_animation(
         // no request animation frame here to stop render animation
         data->playing_adhoc_animation = false;
     }
+    zmk_animation_invalidate_frame_cache();
     // Set next animation
-    {  // Lock section
-        if (lock_for_updating_animation(data) != 0) {
-            return;
-        }
-        // check the latest status after taking lock
-        if (data->running) {
-            current = data->running_animation;
-            if (current.animation) {
-                animation_stop(current.animation);
-            }
-            if (!device_is_ready(next.animation)) {  // including NULL
-                LOG_WRN("next animation %s is empty",
-                        data->running_animation.animation->name);
-                set_power(config, false);
-                struct animation_queue_record empty = {
-                    .cancelable = true,
-                };
-                data->running_animation = empty;
-                // keep data->running true
-                // no request animation frame here to stop render animation
-            } else {
-                data->running_animation = next;
-                set_power(config, true);
-                animation_start(data->running_animation.animation,
-                                data->running_animation.duration_ms);
-                // give chance to change animation in next cycle even if
-                // animation didn't start
-                zmk_animation_request_frames(1);
+    // the oldest animation is cut if a fade is in progress, also when
+    // switching back to it in the middle of the fade
+    stop_crossfade(dev);
+    // animations sharing a device can't run at the same time, e.g. a compose
+    // and its child. Stopping the outgoing one at the end of the fade would
+    // stop the shared device of the incoming one. A finished animation has
+    // nothing left to fade out.
+    if (current.animation && config->crossfade_frames > 0 &&
+        device_is_ready(next.animation) &&
+        !animation_is_finished(current.animation) &&
+        !animation_shares(current.animation, next.animation)) {
+        start_crossfade(dev, current.animation, next.animation);
+    } else if (current.animation) {
+        animation_stop(current.animation);
+    }
+    animation_handle_finish(config->que, current.handle);
+    if (!device_is_ready(next.animation)) {  // including NULL
+        LOG_WRN("next animation of %s is empty", dev->name);
+        request_power(dev, false);
+        struct animation_queue_record empty = {
+            .cancelable = true,
+        };
+        data->running_animation = empty;
+        // keep data->running true
+        // no request animation frame here to stop render animation
+    } else {
+        size_t i = 0;
+        while (i < data->num_overlays) {
+            if (animation_contains(next.animation,
+                                   config->overlays[i].animation)) {
+                // the animation can't run twice
+                remove_overlay(dev, i);
+                continue;
             }
-        } else {
-            LOG_WRN(
-                "animation %s is not running (after taking "
-                "lock)",
-                dev->name);
+            i++;
         }
-        if (unlock_after_updating_animation(data) != 0) {
-            return;
+        data->running_animation = next;
+        if (!data->power_gated) {
+            // gated power is restored by the first non-black frame
+            request_power(dev, true);
         }
+        data->divider.divider = get_frame_divider(dev, next.animation);
+        zmk_animation_divider_reset(&data->divider);
+        animation_start_with_params(data->running_animation.animation,
+                                    data->running_animation.duration_ms,
+                                    &data->running_animation.params);
+        // give chance to change animation in next cycle even if
+        // animation didn't start
+        zmk_animation_request_frames(1);
     }
 }
 
@@ -319,6 +1028,12 @@ static void animation_control_api_impl_start(const struct device *dev) {
         LOG_INF("animation %s is not active", dev->name);
         return;
     }
+    if (data->stop_after_ramp) {
+        // cancel fading out
+        data->stop_after_ramp = false;
+        ramp_brightness(dev, get_target_brightness(dev));
+        return;
+    }
     if (data->running) {
         LOG_WRN("animation %s already running", dev->name);
         return;
@@ -327,6 +1042,9 @@ static void animation_control_api_impl_start(const struct device *dev) {
     data->running = true;
     // power is set in change_animation
     change_animation(dev, NULL);
+    apply_frame_rate(dev);
+    data->brightness = 0;
+    ramp_brightness(dev, get_target_brightness(dev));
 }
 
 static void animation_control_api_impl_stop(const struct device *dev) {
@@ -337,37 +1055,81 @@ static void animation_control_api_impl_stop(const struct device *dev) {
         LOG_WRN("stop: animation %s is not running", dev->name);
         return;
     }
-    {
-        if (lock_for_updating_animation(data) != 0) {
-            return;
-        }
-        if (data->running) {
-            struct animation_queue_record current = data->running_animation;
-            if (current.animation) {
-                animation_stop(current.animation);
-            }
-            struct animation_queue_record empty = {
-                .cancelable = true,
-            };
-            data->running_animation = empty;
-            set_power(config, false);
-            data->running = false;
-            LOG_DBG("Stop animation control %s", dev->name);
-        } else {
-            LOG_WRN("concurrent update detected");  // safe anyway
-        }
-        if (unlock_after_updating_animation(data) != 0) {
-            return;
+    struct animation_queue_record current = data->running_animation;
+    if (current.animation) {
+        animation_stop(current.animation);
+    }
+    stop_crossfade(dev);
+    remove_overlays(dev);
+    animation_handle_finish(config->que, current.handle);
+    struct animation_queue_record empty = {
+        .cancelable = true,
+    };
+    data->running_animation = empty;
+    request_power(dev, false);
+    data->running         = false;
+    data->power_gated     = false;
+    data->stop_after_ramp = false;
+    zmk_animation_invalidate_frame_cache();
+    LOG_DBG("Stop animation control %s", dev->name);
+}
+
+/**
+ * Turn power off after power-off-black-frames consecutive black frames and
+ * turn it on again before the first non-black frame. Power is turned off only
+ * after the LEDs are off, since interpolation, dithering and global brightness
+ * can still light LEDs for a black frame.
+ */
+static void gate_power_by_frame(const struct device *dev,
+                                struct animation_pixel *pixels,
+                                size_t num_pixels) {
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+    if (config->power_off_black_frames == 0) {
+        return;
+    }
+
+    // lit pixels of this frame reach the output after it, check both
+    const uint32_t black_frames = zmk_animation_get_black_output_frames();
+    bool black                  = black_frames > 0;
+    for (size_t i = 0; i < num_pixels && black; ++i) {
+        struct led_rgb led;
+        zmk_rgb_to_led_rgb(&pixels[i].value, &led);
+        black = led.r == 0 && led.g == 0 && led.b == 0;
+    }
+
+    if (!black) {
+        if (data->power_gated) {
+            data->power_gated = false;
+            request_power(dev, true);
         }
+        return;
+    }
+    if (data->power_gated) {
+        return;
     }
+    if (black_frames < config->power_off_black_frames) {
+        // keep rendering until enough black frames are sent
+        zmk_animation_request_frames(1);
+        return;
+    }
+    LOG_DBG("%d black frames, gate power", black_frames);
+    data->power_gated = true;
+    request_power(dev, false);
 }
 
+static void apply_commands(const struct device *dev);
+static int post_play_command(const struct device *dev,
+                             enum animation_control_command_type type,
+                             const struct animation_queue_record *record);
+
 static void animation_control_api_impl_render_frame(
     const struct device *dev, struct animation_pixel *pixels,
     size_t num_pixels) {
     const struct animation_control_config *config = dev->config;
     struct animation_control_data *data           = dev->data;
-    if (!data->s.active) {
+    apply_commands(dev);
+    if (!data->s.active && !data->stop_after_ramp) {
         LOG_INF("animation %s inactive, skipped render", dev->name);
         return;
     }
@@ -375,32 +1137,43 @@ static void animation_control_api_impl_render_frame(
         LOG_INF("animation %s not running, skipped render", dev->name);
         return;
     }
-    // take data snapshot for lockfree thread safety
     struct animation_queue_record current = data->running_animation;
     if (current.animation) {
-        animation_render_frame(current.animation, pixels, num_pixels);
-
-        uint8_t brightness = data->last_powered ? data->s.powered_brightness
-                                                : data->s.battery_brightness;
+        if (data->fade_from != NULL) {
+            render_crossfade(dev, pixels, num_pixels);
+        } else {
+            zmk_animation_render_divided(current.animation, &data->divider,
+                                         pixels, num_pixels);
+        }
+        render_overlays(dev, pixels, num_pixels);
 
-        if (brightness < config->brightness_steps) {
-            float fbrightness =
-                (float)brightness / (float)config->brightness_steps;
-            float fmax_brightness =
-                (float)config->max_brightness / (float)UINT8_MAX;
-            float multiplier = fbrightness * fmax_brightness;
+        step_brightness_ramp(dev);
+        if (data->brightness < 1.0f) {
             for (size_t i = 0; i < num_pixels; ++i) {
-                pixels[i].value.r *= multiplier;
-                pixels[i].value.g *= multiplier;
-                pixels[i].value.b *= multiplier;
+                pixels[i].value.r *= data->brightness;
+                pixels[i].value.g *= data->brightness;
+                pixels[i].value.b *= data->brightness;
             }
         }
     }
+    // also evaluated with no animation to gate the black output
+    gate_power_by_frame(dev, pixels, num_pixels);
+    // the animation slot can become empty while fading out
+    if (data->stop_after_ramp &&
+        (data->brightness_ramp_left == 0 || current.animation == NULL)) {
+        LOG_DBG("faded out");
+        animation_stop(dev);
+        return;
+    }
     const bool animation_finished =
-        current.animation ? animation_is_finished(current.animation) : true;
+        current.animation ? animation_is_finished(current.animation) &&
+                                !restart_if_extended(dev, &current)
+                          : true;
+    // canceled by the handle regardless of cancelability
     const bool should_cancel =
-        current.cancelable && (data->change_animation_if_cancelable ||
-                               k_msgq_num_used_get(&config->que->que) > 0);
+        animation_handle_is_canceled(config->que, current.handle) ||
+        (current.cancelable && (data->change_animation_if_cancelable ||
+                                !animation_queue_is_empty(config->que)));
     if (animation_finished || should_cancel) {
         LOG_DBG("change animation by %s",
                 animation_finished ? "finished" : "cancelable");
@@ -408,11 +1181,26 @@ static void animation_control_api_impl_render_frame(
     }
 }
 
-static int animation_control_api_impl_enqueue_animation(
-    const struct device *dev, const struct device *animation, bool cancelable,
-    uint32_t duration_ms) {
+static uint32_t animation_control_api_impl_get_period(
+    const struct device *dev) {
+    const struct animation_control_config *config = dev->config;
+    const struct animation_control_data *data     = dev->data;
+    if (!data->s.active || !data->running || data->playing_adhoc_animation ||
+        data->brightness_ramp_left > 0 || data->fade_from != NULL ||
+        data->num_overlays > 0 || !animation_queue_is_empty(config->que)) {
+        return 0;
+    }
+    struct animation_queue_record current = data->running_animation;
+    return current.animation ? animation_get_period(current.animation) *
+                                   data->divider.divider
+                             : 0;
+}
+
+static int animation_control_api_impl_enqueue_request(
+    const struct device *dev, const struct animation_control_request *request) {
     const struct animation_control_config *config = dev->config;
     const struct animation_control_data *data     = dev->data;
+    const struct device *animation                = request->animation;
     if (!data->s.active) {
         LOG_WRN("animation %s inactive, skipped %s", dev->name,
                 animation->name);
@@ -425,47 +1213,136 @@ static int animation_control_api_impl_enqueue_animation(
     }
     const struct animation_queue_record record = {
         .animation   = animation,
-        .cancelable  = cancelable,
-        .duration_ms = duration_ms,
+        .cancelable  = request->cancelable,
+        .duration_ms = request->duration_ms,
+        .priority    = request->priority,
+        .expires_at =
+            request->expiry_ms > 0 ? k_uptime_get() + request->expiry_ms : 0,
+        .params = request->params,
     };
-    int res = k_msgq_put(&config->que->que, &record, K_NO_WAIT);
-    if (res != 0) {
-        LOG_ERR("Failed to put animation %s in queue: %d", animation->name,
-                res);
-        return res;
+    if (request->play_now) {
+        return post_play_command(dev, ANIMATION_CONTROL_COMMAND_PLAY_NOW,
+                                 &record);
+    }
+    if (request->overlay && config->overlay_slots > 0) {
+        return post_play_command(dev, ANIMATION_CONTROL_COMMAND_PLAY_OVERLAY,
+                                 &record);
+    }
+    int handle = animation_queue_push(config->que, &record);
+    if (handle < 0) {
+        LOG_WRN("Animation queue is full, skipped %s", animation->name);
+        return handle;
     }
     LOG_DBG("Animation %s enqueued", animation->name);
+    zmk_animation_invalidate_frame_cache();
     zmk_animation_request_frames(1);  // force trigger change animation
-    return 0;
+    return handle;
 }
 
-static int animation_control_api_impl_play_now(const struct device *dev,
-                                               const struct device *animation,
-                                               bool cancelable,
-                                               uint32_t duration_ms) {
+static int animation_control_api_impl_enqueue_animation(
+    const struct device *dev, const struct device *animation, bool cancelable,
+    uint32_t duration_ms) {
+    const struct animation_control_config *config = dev->config;
+    const struct animation_control_request request = {
+        .animation   = animation,
+        .cancelable  = cancelable,
+        .duration_ms = duration_ms,
+        .expiry_ms   = config->queue_expiry_ms,
+    };
+    return animation_control_api_impl_enqueue_request(dev, &request);
+}
+
+static void apply_play_now(const struct device *dev,
+                           struct animation_queue_record *record) {
     const struct animation_control_config *config = dev->config;
     const struct animation_control_data *data     = dev->data;
     if (!data->s.active) {
         LOG_WRN("animation %s inactive, skipped %s", dev->name,
-                animation->name);
-        return 0;
+                record->animation->name);
+        animation_handle_finish(config->que, record->handle);
+        return;
     }
     if (!data->running) {
         LOG_WRN("animation %s not running, skipped %s", dev->name,
-                animation->name);
-        return 0;
+                record->animation->name);
+        animation_handle_finish(config->que, record->handle);
+        return;
     }
-    struct animation_queue_record record = {
-        .animation   = animation,
-        .cancelable  = cancelable,
-        .duration_ms = duration_ms,
-    };
-    change_animation(dev, &record);
-    return 0;
+    if (!animation_handle_start(config->que, record)) {
+        LOG_DBG("%s canceled before it started", record->animation->name);
+        return;
+    }
+    change_animation(dev, record);
 }
 
-static void animation_control_api_impl_set_enabled(const struct device *dev,
-                                                   bool enabled) {
+/**
+ * @return true if the animation is the base animation or the fading out one,
+ * or can be played by them. It shares the state with them and can't overlay.
+ */
+static bool is_played_by_base(const struct device *dev,
+                              const struct device *animation) {
+    const struct animation_control_data *data = dev->data;
+
+    const struct device *base = data->running_animation.animation;
+    return (base != NULL && animation_contains(base, animation)) ||
+           (data->fade_from != NULL &&
+            animation_contains(data->fade_from, animation));
+}
+
+/**
+ * Start the overlay on top of the base animation. An overlay of the same
+ * animation is restarted, and the overlay with the lowest priority is
+ * replaced if all slots are used.
+ */
+static void apply_play_overlay(const struct device *dev,
+                               struct animation_queue_record *record) {
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+    if (!data->s.active || !data->running ||
+        is_played_by_base(dev, record->animation)) {
+        LOG_DBG("Skipped overlay %s", record->animation->name);
+        animation_handle_finish(config->que, record->handle);
+        return;
+    }
+    if (data->running_animation.animation == NULL) {
+        // nothing to overlay, e.g. LEDs are off on battery
+        apply_play_now(dev, record);
+        return;
+    }
+    for (size_t i = 0; i < data->num_overlays; ++i) {
+        if (config->overlays[i].animation == record->animation) {
+            remove_overlay(dev, i);
+            break;
+        }
+    }
+    if (data->num_overlays == config->overlay_slots) {
+        if (config->overlays[0].priority > record->priority) {
+            LOG_WRN("No overlay slot for %s", record->animation->name);
+            animation_handle_finish(config->que, record->handle);
+            return;
+        }
+        remove_overlay(dev, 0);
+    }
+    if (!animation_handle_start(config->que, record)) {
+        LOG_DBG("%s canceled before it started", record->animation->name);
+        return;
+    }
+    // newer overlays are drawn above overlays with the same priority
+    size_t pos = data->num_overlays;
+    while (pos > 0 && config->overlays[pos - 1].priority > record->priority) {
+        config->overlays[pos] = config->overlays[pos - 1];
+        pos--;
+    }
+    config->overlays[pos] = *record;
+    data->num_overlays++;
+    LOG_DBG("Start overlay %s", record->animation->name);
+    animation_start_with_params(record->animation, record->duration_ms,
+                                &record->params);
+    zmk_animation_invalidate_frame_cache();
+    zmk_animation_request_frames(1);
+}
+
+static void apply_set_enabled(const struct device *dev, bool enabled) {
     struct animation_control_data *data = dev->data;
     if (data->s.active == enabled) {
         return;
@@ -474,7 +1351,7 @@ static void animation_control_api_impl_set_enabled(const struct device *dev,
     if (data->s.active) {
         animation_start(dev, ANIMATION_DURATION_FOREVER);
     } else {
-        animation_stop(dev);
+        fade_out_and_stop(dev);
     }
 #if IS_ENABLED(CONFIG_SETTINGS)
     animation_control_save_settings(dev);
@@ -488,7 +1365,7 @@ bool select_powered(enum animation_control_power_source source) {
                                                               : false;
 }
 
-static void animation_control_api_impl_set_next_animation(
+static void apply_set_next_animation(
     const struct device *dev, int index_offset,
     enum animation_control_power_source power_source) {
     const struct animation_control_config *config = dev->config;
@@ -511,28 +1388,30 @@ static void animation_control_api_impl_set_next_animation(
             next_animation);
     *current_animation                   = next_animation;
     data->change_animation_if_cancelable = true;
+    zmk_animation_invalidate_frame_cache();
     zmk_animation_request_frames(1);
 #if IS_ENABLED(CONFIG_SETTINGS)
     animation_control_save_settings(dev);
 #endif /* IS_ENABLED(CONFIG_SETTINGS) */
 }
 
-static void animation_control_api_impl_set_animation(
+static void apply_set_animation(
     const struct device *dev, size_t index,
     enum animation_control_power_source power_source) {
     const struct animation_control_config *config = dev->config;
     struct animation_control_data *data           = dev->data;
 
-    bool powered              = select_powered(power_source);
-    size_t *current_animation = powered ? &data->s.current_powered_animation
-                                        : &data->s.current_battery_animation;
-    size_t num_animations     = powered ? config->powered_animations_size
-                                        : config->battery_animations_size;
+    bool powered               = select_powered(power_source);
+    uint8_t *current_animation = powered ? &data->s.current_powered_animation
+                                         : &data->s.current_battery_animation;
+    size_t num_animations      = powered ? config->powered_animations_size
+                                         : config->battery_animations_size;
 
     index = index % num_animations;
     if (*current_animation != index) {
         *current_animation                   = index;
         data->change_animation_if_cancelable = true;
+        zmk_animation_invalidate_frame_cache();
         zmk_animation_request_frames(1);
 #if IS_ENABLED(CONFIG_SETTINGS)
         animation_control_save_settings(dev);
@@ -540,7 +1419,7 @@ static void animation_control_api_impl_set_animation(
     }
 }
 
-static void animation_control_api_impl_change_brightness(
+static void apply_change_brightness(
     const struct device *dev, int brightness_offset,
     enum animation_control_power_source power_source) {
     const struct animation_control_config *config = dev->config;
@@ -561,9 +1440,11 @@ static void animation_control_api_impl_change_brightness(
         LOG_DBG("animation: change brightness %d->%d", current_brightness,
                 next_brightness);
         if (next_brightness == 0) {
-            animation_stop(dev);
+            fade_out_and_stop(dev);
         } else if (current_brightness == 0) {
             animation_start(dev, ANIMATION_DURATION_FOREVER);
+        } else {
+            ramp_brightness(dev, get_target_brightness(dev));
         }
 #if IS_ENABLED(CONFIG_SETTINGS)
         animation_control_save_settings(dev);
@@ -572,6 +1453,237 @@ static void animation_control_api_impl_change_brightness(
     return;
 }
 
+static void apply_set_frame_divider(const struct device *dev,
+                                   uint8_t divider) {
+    struct animation_control_data *data = dev->data;
+    if (data->frame_divider == divider) {
+        return;
+    }
+    data->frame_divider = divider;
+    apply_frame_rate(dev);
+#if IS_ENABLED(CONFIG_SETTINGS)
+    animation_control_save_settings(dev);
+#endif /* IS_ENABLED(CONFIG_SETTINGS) */
+}
+
+static void apply_commands(const struct device *dev) {
+    const struct animation_control_config *config = dev->config;
+    struct animation_control_data *data           = dev->data;
+    struct animation_control_command command;
+    while (k_msgq_get(config->commands, &command, K_NO_WAIT) == 0) {
+        switch (command.type) {
+            case ANIMATION_CONTROL_COMMAND_PLAY_NOW:
+                apply_play_now(dev, &command.record);
+                break;
+            case ANIMATION_CONTROL_COMMAND_PLAY_OVERLAY:
+                apply_play_overlay(dev, &command.record);
+                break;
+            case ANIMATION_CONTROL_COMMAND_STOP_ANIMATION:
+                animation_stop(command.record.animation);
+                // expects the animation returns is_finished true and change
+                // animation happens
+                zmk_animation_invalidate_frame_cache();
+                break;
+            case ANIMATION_CONTROL_COMMAND_SET_ENABLED:
+                apply_set_enabled(dev, command.value);
+                break;
+            case ANIMATION_CONTROL_COMMAND_SET_NEXT_ANIMATION:
+                apply_set_next_animation(dev, command.value,
+                                         command.power_source);
+                break;
+            case ANIMATION_CONTROL_COMMAND_SET_ANIMATION:
+                apply_set_animation(dev, command.value, command.power_source);
+                break;
+            case ANIMATION_CONTROL_COMMAND_CHANGE_BRIGHTNESS:
+                apply_change_brightness(dev, command.value,
+                                        command.power_source);
+                break;
+            case ANIMATION_CONTROL_COMMAND_SET_FRAME_DIVIDER:
+                apply_set_frame_divider(dev, command.value);
+                break;
+            case ANIMATION_CONTROL_COMMAND_POWER_SOURCE_CHANGED:
+                // replace the current animation if cancelable, not to stop
+                // non-cancelable animations
+                data->change_animation_if_cancelable = data->running;
+                break;
+            case ANIMATION_CONTROL_COMMAND_BATTERY_CHANGED:
+                if (data->running) {
+                    apply_frame_rate(dev);
+                }
+                break;
+        }
+    }
+}
+
+/**
+ * Send the command to the render context. It's applied on the next frame.
+ */
+static int post_command(const struct device *dev,
+                        const struct animation_control_command *command) {
+    const struct animation_control_config *config = dev->config;
+    int rc = k_msgq_put(config->commands, command, K_NO_WAIT);
+    if (rc != 0) {
+        LOG_ERR("animation %s: failed to post command %d: %d", dev->name,
+                command->type, rc);
+        return rc;
+    }
+    // the replayed frame cache doesn't render the root, so commands would
+    // never be applied
+    zmk_animation_invalidate_frame_cache();
+    zmk_animation_request_frames(1);
+    return 0;
+}
+
+/**
+ * Send the play command with a new handle for the record.
+ * @return handle, or negative error code
+ */
+static int post_play_command(const struct device *dev,
+                             enum animation_control_command_type type,
+                             const struct animation_queue_record *record) {
+    const struct animation_control_config *config = dev->config;
+
+    struct animation_control_command command = {
+        .type   = type,
+        .record = *record,
+    };
+    k_spinlock_key_t key  = k_spin_lock(&config->que->lock);
+    command.record.handle = animation_handle_alloc(config->que);
+    k_spin_unlock(&config->que->lock, key);
+    if (command.record.handle == 0) {
+        // handle 0 is reserved for animations of the power state
+        LOG_WRN("No free handle, skipped %s", record->animation->name);
+        return -ENOMEM;
+    }
+    int rc = post_command(dev, &command);
+    if (rc != 0) {
+        animation_handle_finish(config->que, command.record.handle);
+        return rc;
+    }
+    return command.record.handle;
+}
+
+static int animation_control_api_impl_play_now(const struct device *dev,
+                                               const struct device *animation,
+                                               bool cancelable,
+                                               uint32_t duration_ms) {
+    const struct animation_queue_record record = {
+        .animation   = animation,
+        .cancelable  = cancelable,
+        .duration_ms = duration_ms,
+    };
+    return post_play_command(dev, ANIMATION_CONTROL_COMMAND_PLAY_NOW, &record);
+}
+
+static int animation_control_api_impl_cancel(const struct device *dev,
+                                             int handle) {
+    const struct animation_control_config *config = dev->config;
+
+    k_spinlock_key_t key = k_spin_lock(&config->que->lock);
+    struct animation_handle_slot *slot =
+        animation_handle_get(config->que, handle);
+    bool found = slot != NULL && !slot->canceled;
+    bool playing =
+        found && slot->state == ANIMATION_CONTROL_HANDLE_PLAYING;
+    if (found) {
+        // queued records are dropped on the next queue access
+        slot->canceled = true;
+    }
+    k_spin_unlock(&config->que->lock, key);
+    if (!found) {
+        return -ENOENT;
+    }
+    if (playing) {
+        zmk_animation_invalidate_frame_cache();
+    }
+    zmk_animation_request_frames(1);
+    return 0;
+}
+
+static int animation_control_api_impl_extend(const struct device *dev,
+                                             int handle,
+                                             uint32_t duration_ms) {
+    const struct animation_control_config *config = dev->config;
+
+    k_spinlock_key_t key = k_spin_lock(&config->que->lock);
+    struct animation_handle_slot *slot =
+        animation_handle_get(config->que, handle);
+    bool found = slot != NULL && !slot->canceled;
+    if (found && slot->state == ANIMATION_CONTROL_HANDLE_QUEUED) {
+        slot->extended_ms += duration_ms;
+    } else if (found && slot->ends_at != 0) {
+        slot->ends_at += duration_ms;
+        slot->extended = true;
+    }
+    k_spin_unlock(&config->que->lock, key);
+    return found ? 0 : -ENOENT;
+}
+
+static enum animation_control_handle_state
+animation_control_api_impl_get_state(const struct device *dev, int handle) {
+    const struct animation_control_config *config = dev->config;
+
+    k_spinlock_key_t key = k_spin_lock(&config->que->lock);
+    const struct animation_handle_slot *slot =
+        animation_handle_get(config->que, handle);
+    enum animation_control_handle_state state =
+        slot == NULL || slot->canceled ? ANIMATION_CONTROL_HANDLE_DONE
+                                       : slot->state;
+    k_spin_unlock(&config->que->lock, key);
+    return state;
+}
+
+static void animation_control_api_impl_set_enabled(const struct device *dev,
+                                                   bool enabled) {
+    const struct animation_control_command command = {
+        .type  = ANIMATION_CONTROL_COMMAND_SET_ENABLED,
+        .value = enabled,
+    };
+    post_command(dev, &command);
+}
+
+static void animation_control_api_impl_set_next_animation(
+    const struct device *dev, int index_offset,
+    enum animation_control_power_source power_source) {
+    const struct animation_control_command command = {
+        .type         = ANIMATION_CONTROL_COMMAND_SET_NEXT_ANIMATION,
+        .value        = index_offset,
+        .power_source = power_source,
+    };
+    post_command(dev, &command);
+}
+
+static void animation_control_api_impl_set_animation(
+    const struct device *dev, int index,
+    enum animation_control_power_source power_source) {
+    const struct animation_control_command command = {
+        .type         = ANIMATION_CONTROL_COMMAND_SET_ANIMATION,
+        .value        = index,
+        .power_source = power_source,
+    };
+    post_command(dev, &command);
+}
+
+static void animation_control_api_impl_change_brightness(
+    const struct device *dev, int brightness_offset,
+    enum animation_control_power_source power_source) {
+    const struct animation_control_command command = {
+        .type         = ANIMATION_CONTROL_COMMAND_CHANGE_BRIGHTNESS,
+        .value        = brightness_offset,
+        .power_source = power_source,
+    };
+    post_command(dev, &command);
+}
+
+static void animation_control_api_impl_set_frame_divider(
+    const struct device *dev, uint8_t divider) {
+    const struct animation_control_command command = {
+        .type  = ANIMATION_CONTROL_COMMAND_SET_FRAME_DIVIDER,
+        .value = divider,
+    };
+    post_command(dev, &command);
+}
+
 static int animation_control_api_impl_enqueue_by_index(const struct device *dev,
                                                        uint8_t index,
                                                        bool cancelable,
@@ -609,23 +1721,28 @@ static int animation_control_api_impl_stop_by_index(const struct device *dev,
         LOG_ERR("animation %s index out of range %d", dev->name, index);
         return -EINVAL;
     }
-    const struct device *animation = config->behavior_animations[index];
-    animation_stop(animation);
-    // expects the animation returns is_finished true and change animation
-    // happens
-    zmk_animation_request_frames(1);
-    return 0;
+    const struct animation_control_command command = {
+        .type   = ANIMATION_CONTROL_COMMAND_STOP_ANIMATION,
+        .record = {.animation = config->behavior_animations[index]},
+    };
+    return post_command(dev, &command);
 }
 
 static void animation_control_on_usb_conn_state_changed(
     const struct device *dev, const struct zmk_usb_conn_state_changed *event) {
-    const struct animation_control_config *config = dev->config;
-    struct animation_control_data *data           = dev->data;
-    if (data->running) {
-        // enqueue empty animation to trigger change animation
-        // change animation is not called here not to stop current animation
-        animation_control_enqueue_animation(dev, NULL, true, 1);
-    }
+    const struct animation_control_command command = {
+        .type = ANIMATION_CONTROL_COMMAND_POWER_SOURCE_CHANGED,
+    };
+    post_command(dev, &command);
+}
+
+static void animation_control_on_battery_state_changed(
+    const struct device *dev,
+    const struct zmk_battery_state_changed *event) {
+    const struct animation_control_command command = {
+        .type = ANIMATION_CONTROL_COMMAND_BATTERY_CHANGED,
+    };
+    post_command(dev, &command);
 }
 
 static void animation_control_on_activity_state_changed(
@@ -678,11 +1795,25 @@ static int animation_control_init(const struct device *dev) {
                     config->ext_power->name);
             return -ENODEV;
         }
+        // the rail is usually left on at boot, and must be turned off even if
+        // power is never requested. Assume on if the state is unknown.
+        data->power_on = ext_power_get(config->ext_power) != 0;
+    }
+    for (size_t i = 0; i <= config->brightness_steps; i++) {
+        float level = config->brightness_steps == 0
+                          ? 1.0f
+                          : (float)i / config->brightness_steps;
+        if (config->brightness_curve_cie) {
+            // CIE 1976 lightness L* to relative luminance
+            float lightness = level * 100;
+            level = lightness > 8 ? powf((lightness + 16) / 116, 3)
+                                  : lightness / 903.3f;
+        }
+        config->brightness_levels[i] =
+            level * config->max_brightness / UINT8_MAX;
     }
-    k_msgq_init(&config->que->que, config->que->que_buffer,
-                sizeof(struct animation_queue_record),
-                config->que->que_buffer_size);
-    k_mutex_init(&data->mutex);
+    k_work_init_delayable(&config->work->power_off_work,
+                          animation_control_power_off_work);
     if (config->init_animation != NULL) {
         k_work_init_delayable(&config->work->init_animation_work,
                               enqueue_initial_animation_work);
@@ -700,8 +1831,10 @@ static const struct animation_control_api api = {
             .on_stop      = animation_control_api_impl_stop,
             .render_frame = animation_control_api_impl_render_frame,
             .is_finished  = animation_control_api_impl_is_finished,
+            .get_period   = animation_control_api_impl_get_period,
         },
     .enqueue_animation  = animation_control_api_impl_enqueue_animation,
+    .enqueue_request    = animation_control_api_impl_enqueue_request,
     .play_now           = animation_control_api_impl_play_now,
     .set_enabled        = animation_control_api_impl_set_enabled,
     .set_next_animation = animation_control_api_impl_set_next_animation,
@@ -710,8 +1843,38 @@ static const struct animation_control_api api = {
     .enqueue_by_index   = animation_control_api_impl_enqueue_by_index,
     .play_now_by_index  = animation_control_api_impl_play_now_by_index,
     .stop_by_index      = animation_control_api_impl_stop_by_index,
+    .set_frame_divider  = animation_control_api_impl_set_frame_divider,
+    .cancel             = animation_control_api_impl_cancel,
+    .extend             = animation_control_api_impl_extend,
+    .get_state          = animation_control_api_impl_get_state,
 };
 
+#define FRAME_DIVIDER_ENTRY(node_id)                                      \
+    COND_CODE_1(                                                          \
+        CONFIG_ZMK_ANIMATION_FRAME_DIVIDERS,                              \
+        (COND_CODE_1(IS_EQ(DT_PROP_OR(node_id, frame_divider, 1), 1), (), \
+                     ({                                                   \
+                          .animation = DEVICE_DT_GET(node_id),            \
+                          .divider   = DT_PROP(node_id, frame_divider),   \
+                      }, ))),                                             \
+        ())
+
+#define PHANDLE_TO_FRAME_DIVIDER(node_id, prop, idx) \
+    FRAME_DIVIDER_ENTRY(DT_PHANDLE_BY_IDX(node_id, prop, idx))
+
+#define OPTIONAL_PHANDLE_TO_FRAME_DIVIDER(node_id, prop) \
+    COND_CODE_1(DT_NODE_HAS_PROP(node_id, prop),         \
+                (FRAME_DIVIDER_ENTRY(DT_PHANDLE(node_id, prop))), ())
+
+#define ANIMATION_CONTROL_FADE_PIXELS(idx) \
+    (DT_INST_PROP(idx, crossfade_ms) > 0 ? ZMK_ANIMATION_NUM_PIXELS : 0)
+
+// queued records, play commands waiting for the next frame, overlays and the
+// playing record
+#define ANIMATION_CONTROL_NUM_HANDLES(idx)                                   \
+    (DT_INST_PROP(idx, queue_size) + DT_INST_PROP(idx, command_queue_size) + \
+     DT_INST_PROP(idx, overlay_slots) + 1)
+
 #define ANIMATION_CONTROL_DEVICE(idx)                                        \
                                                                              \
     static const struct device                                               \
@@ -728,6 +1891,33 @@ static const struct animation_control_api api = {
             DT_INST_FOREACH_PROP_ELEM(idx, behavior_animations,              \
                                       PHANDLE_TO_DEVICE)};                   \
                                                                              \
+    static const struct animation_control_frame_divider                      \
+        animation_control_##idx##_frame_dividers[] = {                       \
+            DT_INST_FOREACH_PROP_ELEM(idx, powered_animations,               \
+                                      PHANDLE_TO_FRAME_DIVIDER)              \
+            DT_INST_FOREACH_PROP_ELEM(idx, battery_animations,               \
+                                      PHANDLE_TO_FRAME_DIVIDER)              \
+            DT_INST_FOREACH_PROP_ELEM(idx, behavior_animations,              \
+                                      PHANDLE_TO_FRAME_DIVIDER)              \
+            OPTIONAL_PHANDLE_TO_FRAME_DIVIDER(DT_DRV_INST(idx),              \
+                                              init_animation)                \
+            OPTIONAL_PHANDLE_TO_FRAME_DIVIDER(DT_DRV_INST(idx),              \
+                                              activation_animation)};        \
+    static struct zmk_color_rgb                                              \
+        animation_control_##idx##_held[COND_CODE_1(                          \
+            CONFIG_ZMK_ANIMATION_FRAME_DIVIDERS, (ZMK_ANIMATION_NUM_PIXELS), \
+            (0))];                                                           \
+                                                                             \
+    static float animation_control_##idx##_brightness_levels                 \
+        [DT_INST_PROP(idx, brightness_steps)];                               \
+    static struct animation_queue_record                                     \
+        animation_control_##idx##_overlays                                   \
+            [DT_INST_PROP(idx, overlay_slots)];                              \
+    static struct zmk_color_rgb animation_control_##idx##_fade_buffer        \
+        [ANIMATION_CONTROL_FADE_PIXELS(idx)];                                \
+    static size_t animation_control_##idx##_fade_pixel_map                   \
+        [ANIMATION_CONTROL_FADE_PIXELS(idx)];                                \
+                                                                             \
     static struct animation_control_work_context                             \
         animation_control_##idx##_work = {                                   \
             .animation = DEVICE_DT_GET(DT_DRV_INST(idx)),                    \
@@ -748,13 +1938,23 @@ static const struct animation_control_api api = {
             .h_set = animation_control_##idx##_load_settings,                \
     };                                                                       \
                                                                              \
-    static char animation_control_##idx##_queue_buffer                       \
-        [DT_INST_PROP(idx, queue_size) *                                     \
-         sizeof(struct animation_queue_record)];                             \
+    static struct animation_queue_record                                     \
+        animation_control_##idx##_queue_records                              \
+            [DT_INST_PROP(idx, queue_size)];                                 \
+    static struct animation_handle_slot                                      \
+        animation_control_##idx##_handle_slots                               \
+            [ANIMATION_CONTROL_NUM_HANDLES(idx)];                            \
     static struct animation_queue animation_control_##idx##_queue = {        \
-        .que_buffer      = animation_control_##idx##_queue_buffer,           \
-        .que_buffer_size = DT_INST_PROP(idx, queue_size),                    \
+        .records   = animation_control_##idx##_queue_records,                \
+        .capacity  = DT_INST_PROP(idx, queue_size),                          \
+        .slots     = animation_control_##idx##_handle_slots,                 \
+        .num_slots = ANIMATION_CONTROL_NUM_HANDLES(idx),                     \
     };                                                                       \
+    BUILD_ASSERT(ANIMATION_CONTROL_NUM_HANDLES(idx) <= UINT8_MAX + 1,        \
+                 "queue-size and command-queue-size exceed handle slots");   \
+    K_MSGQ_DEFINE(animation_control_##idx##_commands,                        \
+                  sizeof(struct animation_control_command),                  \
+                  DT_INST_PROP(idx, command_queue_size), 4);                 \
                                                                              \
     static const struct animation_control_config                             \
         animation_control_##idx##_config = {                                 \
@@ -782,11 +1982,39 @@ static const struct animation_control_api api = {
                 DT_INST_PROP(idx, activation_animation_duration_ms),         \
             .brightness_steps = DT_INST_PROP(idx, brightness_steps) - 1,     \
             .max_brightness   = DT_INST_PROP(idx, max_brightness),           \
+            .brightness_curve_cie =                                          \
+                DT_INST_ENUM_IDX(idx, brightness_curve) == 1,                \
+            .brightness_ramp_frames = ANIMATION_DURATION_MS_TO_FRAMES(       \
+                DT_INST_PROP(idx, brightness_ramp_ms)),                      \
+            .brightness_levels =                                             \
+                animation_control_##idx##_brightness_levels,                 \
+            .overlays      = animation_control_##idx##_overlays,             \
+            .overlay_slots = DT_INST_PROP(idx, overlay_slots),               \
+            .crossfade_frames = ANIMATION_DURATION_MS_TO_FRAMES(             \
+                DT_INST_PROP(idx, crossfade_ms)),                            \
+            .fade_buffer    = animation_control_##idx##_fade_buffer,         \
+            .fade_pixel_map = animation_control_##idx##_fade_pixel_map,      \
+            .battery_frame_divider =                                         \
+                DT_INST_PROP(idx, battery_frame_divider),                    \
+            .low_battery_frame_divider =                                     \
+                DT_INST_PROP(idx, low_battery_frame_divider),                \
+            .low_battery_threshold =                                         \
+                DT_INST_PROP(idx, low_battery_threshold),                    \
             .work             = &animation_control_##idx##_work,             \
             .settings_handler = &animation_control_##idx##_settings_handler, \
             .que              = &animation_control_##idx##_queue,            \
+            .queue_expiry_ms  = DT_INST_PROP(idx, queue_expiry_ms),          \
+            .commands         = &animation_control_##idx##_commands,         \
+            .frame_dividers   = animation_control_##idx##_frame_dividers,    \
+            .frame_dividers_size =                                           \
+                ARRAY_SIZE(animation_control_##idx##_frame_dividers),        \
             .ext_power =                                                     \
                 DEVICE_DT_GET_OR_NULL(DT_INST_PHANDLE(idx, ext_power)),      \
+            .ext_power_settle_ms = DT_INST_PROP(idx, ext_power_settle_ms),   \
+            .ext_power_off_delay_ms =                                        \
+                DT_INST_PROP(idx, ext_power_off_delay_ms),                   \
+            .power_off_black_frames =                                        \
+                DT_INST_PROP(idx, power_off_black_frames),                   \
     };                                                                       \
                                                                              \
     static struct animation_control_data animation_control_##idx##_data = {  \
@@ -798,6 +2026,11 @@ static const struct animation_control_api api = {
                 .current_powered_animation = 0,                              \
                 .current_battery_animation = 0,                              \
             },                                                               \
+        .divider =                                                           \
+            {                                                                \
+                .divider = 1,                                                \
+                .held    = animation_control_##idx##_held,                   \
+            },                                                               \
     };                                                                       \
                                                                              \
     DEVICE_DT_INST_DEFINE(idx, &animation_control_init, NULL,                \
@@ -834,6 +2067,12 @@ static int event_listener(const zmk_event_t *eh) {
                 animation_control_devices[i],
                 as_zmk_activity_state_changed(eh));
         }
+    } else if (as_zmk_battery_state_changed(eh)) {
+        for (size_t i = 0; i < control_animations_size; i++) {
+            animation_control_on_battery_state_changed(
+                animation_control_devices[i],
+                as_zmk_battery_state_changed(eh));
+        }
     }
     return ZMK_EV_EVENT_BUBBLE;
 }
@@ -841,6 +2080,7 @@ static int event_listener(const zmk_event_t *eh) {
 ZMK_LISTENER(animation_control, event_listener);
 ZMK_SUBSCRIPTION(animation_control, zmk_usb_conn_state_changed);
 ZMK_SUBSCRIPTION(animation_control, zmk_activity_state_changed);
+ZMK_SUBSCRIPTION(animation_control, zmk_battery_state_changed);
 
 #endif /* DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT) */
 
@@ -940,4 +2180,32 @@ int animation_control_stop_by_index0(uint8_t index) {
     }
     return animation_control_stop_by_index(dev0, index);
 }
+
+void animation_control_set_frame_divider0(uint8_t divider) {
+    if (!is_dev0_ready()) {
+        return;
+    }
+    animation_control_set_frame_divider(dev0, divider);
+}
+
+int animation_control_cancel0(int handle) {
+    if (!is_dev0_ready()) {
+        return -ENODEV;
+    }
+    return animation_control_cancel(dev0, handle);
+}
+
+int animation_control_extend0(int handle, uint32_t duration_ms) {
+    if (!is_dev0_ready()) {
+        return -ENODEV;
+    }
+    return animation_control_extend(dev0, handle, duration_ms);
+}
+
+enum animation_control_handle_state animation_control_get_state0(int handle) {
+    if (!is_dev0_ready()) {
+        return ANIMATION_CONTROL_HANDLE_DONE;
+    }
+    return animation_control_get_state(dev0, handle);
+}
 #endif
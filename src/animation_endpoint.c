@@ -60,6 +60,7 @@ struct animation_endpoint_config {
 };
 struct animation_endpoint_data {
     bool running;
+    bool forever;
     uint32_t counter;
     uint32_t blink_counter;
 #if IS_CENTRAL
@@ -97,6 +98,7 @@ void refresh_ble_connection_status(const struct device *dev) {
         data->central_status = BLE_STATUS_DISCONNECTED;
     }
 #endif
+    zmk_animation_invalidate_frame_cache();
     if (!is_connected && data->counter < config->not_connected_duration) {
         data->counter = config->not_connected_duration;
         zmk_animation_request_frames_if_required(data->counter, true);
@@ -248,8 +250,9 @@ static void animation_endpoint_render_frame(const struct device *dev,
 #elif IS_SPLIT_PERIPHERAL
     update_pixels_peripheral(dev, pixels, num_pixels);
 #endif
-    data->blink_counter++;
-    data->counter = counter - 1;
+    uint32_t step = zmk_animation_get_frame_step();
+    data->counter = counter > step ? counter - step : 0;
+    data->blink_counter += step;
     zmk_animation_request_frames_if_required(data->counter, false);
     if (data->counter == 0) {
         LOG_INF("Stop animation endpoint status by counter");
@@ -265,6 +268,7 @@ static void animation_endpoint_start(const struct device *dev,
     data->counter = request_duration_ms == 0
                         ? ANIMATION_DURATION_FOREVER
                         : ANIMATION_DURATION_MS_TO_FRAMES(request_duration_ms);
+    data->forever = data->counter == ANIMATION_DURATION_FOREVER;
     if (!data->running) {
         data->blink_counter = 0;
         data->running       = true;
@@ -289,27 +293,59 @@ static bool animation_endpoint_is_finished(const struct device *dev) {
     return !data->running;
 }
 
+static uint32_t animation_endpoint_get_period(const struct device *dev) {
+    const struct animation_endpoint_config *config = dev->config;
+    struct animation_endpoint_data *data           = dev->data;
+    if (!data->running || !data->forever) {
+        return 0;
+    }
+#if IS_CENTRAL
+    return config->blink_duration;
+#elif IS_SPLIT_PERIPHERAL
+    return config->blink_duration * 2 - 1;
+#else
+    return 0;
+#endif
+}
+
 void on_endpoint_status_change(const struct device *dev) {
     const struct animation_endpoint_config *config = dev->config;
     struct animation_endpoint_data *data           = dev->data;
     if (!data->running && config->duration_seconds_on_endpoint_change > 0) {
         if (k_uptime_get() > config->event_handling_start_seconds * 1000) {
-            animation_control_enqueue_animation(
-                animation_control, dev, false,
-                config->duration_seconds_on_endpoint_change * 1000);
+            const uint32_t duration_ms =
+                config->duration_seconds_on_endpoint_change * 1000;
+            // the status is stale if it can't be shown in time
+            const struct animation_control_request request = {
+                .animation   = dev,
+                .duration_ms = duration_ms,
+                .expiry_ms   = duration_ms,
+                .overlay     = true,
+            };
+            animation_control_enqueue_request(animation_control, &request);
         }
         return;
     }
     refresh_ble_connection_status(dev);
 }
 
+static size_t animation_endpoint_get_pixel_map(const struct device *dev,
+                                               const size_t **pixel_map) {
+    const struct animation_endpoint_config *config = dev->config;
+    *pixel_map                                     = config->pixel_map;
+    return config->pixel_map_size;
+}
+
 static int animation_endpoint_init(const struct device *dev) { return 0; }
 
 static const struct animation_api animation_endpoint_api = {
-    .on_start     = animation_endpoint_start,
-    .on_stop      = animation_endpoint_stop,
-    .render_frame = animation_endpoint_render_frame,
-    .is_finished  = animation_endpoint_is_finished,
+    .on_start        = animation_endpoint_start,
+    .on_stop         = animation_endpoint_stop,
+    .render_frame    = animation_endpoint_render_frame,
+    .is_finished     = animation_endpoint_is_finished,
+    .get_period      = animation_endpoint_get_period,
+    .get_pixel_map   = animation_endpoint_get_pixel_map,
+    .fills_pixel_map = true,
 };
 
 #define ANIMATION_ENDPOINT_DEVICE(idx)                                         \
@@ -49,6 +49,7 @@ struct animation_layer_status_data {
     bool running;
     uint32_t counter;
     uint32_t layer_status;
+    uint32_t rendered_layer_status;
     uint64_t last_set;
 };
 
@@ -115,6 +116,11 @@ static void animation_layer_status_render_frame(const struct device *dev,
     if (counter == 0) {
         return;
     }
+    if (data->layer_status != data->rendered_layer_status) {
+        // layer change should be shown immediately
+        zmk_animation_skip_interpolation();
+        data->rendered_layer_status = data->layer_status;
+    }
     struct zmk_color_rgb black = {};
     struct zmk_color_rgb default_rgb;
     struct zmk_color_hsl default_hsl = {};
@@ -135,7 +141,8 @@ static void animation_layer_status_render_frame(const struct device *dev,
             pixels[config->pixel_map[i]].value = black;
         }
     }
-    data->counter = counter - 1;
+    uint32_t step = zmk_animation_get_frame_step();
+    data->counter = counter > step ? counter - step : 0;
     zmk_animation_request_frames_if_required(data->counter, false);
     if (data->counter == 0) {
         animation_stop(dev);
@@ -186,13 +193,22 @@ static bool animation_layer_status_is_finished(const struct device *dev) {
     return !data->running;
 }
 
+static size_t animation_layer_status_get_pixel_map(const struct device *dev,
+                                                   const size_t **pixel_map) {
+    const struct animation_layer_status_config *config = dev->config;
+    *pixel_map                                         = config->pixel_map;
+    return config->pixel_map_size;
+}
+
 static int animation_layer_status_init(const struct device *dev) { return 0; }
 
 static const struct animation_api animation_layer_status_api = {
-    .on_start     = animation_layer_status_start,
-    .on_stop      = animation_layer_status_stop,
-    .render_frame = animation_layer_status_render_frame,
-    .is_finished  = animation_layer_status_is_finished,
+    .on_start        = animation_layer_status_start,
+    .on_stop         = animation_layer_status_stop,
+    .render_frame    = animation_layer_status_render_frame,
+    .is_finished     = animation_layer_status_is_finished,
+    .get_pixel_map   = animation_layer_status_get_pixel_map,
+    .fills_pixel_map = true,
 };
 
 static struct animation_layer_status_data animation_layer_status_data = {};
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2025 cormoran
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_animation_reactive
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/math_extras.h>
+
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+#include <zmk/matrix.h>
+#include <zmk_driver_animation/color.h>
+#include <zmk_driver_animation/animation.h>
+#include <zmk_driver_animation/drivers/animation.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#if DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT)
+
+/*
+ * Key presses are routed from position state changes to reactive animations
+ * without going through behaviors. Each key position is mapped once at init
+ * to its pixel and the reactive animations rendering that pixel. The listener
+ * pushes the press/release into a ring buffer of each animation, which is
+ * drained when the animation renders the next frame.
+ */
+
+#define REACTIVE_NUM_INSTANCES DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT)
+
+BUILD_ASSERT(REACTIVE_NUM_INSTANCES <= 32,
+             "Too many zmk,animation-reactive instances");
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_ZMK_ANIMATION_REACTIVE_EVENTS),
+             "CONFIG_ZMK_ANIMATION_REACTIVE_EVENTS must be a power of two");
+
+#define REACTIVE_EVENTS_MASK (CONFIG_ZMK_ANIMATION_REACTIVE_EVENTS - 1)
+
+struct reactive_event {
+    uint16_t pixel;
+    bool pressed;
+};
+
+struct reactive_route {
+    uint16_t pixel;
+    // bit i is set if the i-th instance renders the pixel
+    uint32_t animations;
+};
+
+static struct reactive_route routes[ZMK_KEYMAP_LEN];
+
+struct animation_reactive_config {
+    size_t *pixel_map;
+    size_t pixel_map_size;
+    struct zmk_color_hsl *color;
+    uint32_t fade_frames;
+    // per pixel: brightness 0 to 255, number of keys held
+    uint8_t *levels;
+    uint8_t *held;
+    struct reactive_event *events;
+    uint8_t index;
+};
+
+struct animation_reactive_data {
+    bool running;
+    uint32_t counter;
+    // true while pixels are fading out
+    bool fading;
+    struct zmk_color_rgb rgb;
+    // events are pushed by the listener and drained in the render context
+    struct k_spinlock lock;
+    uint32_t events_head;
+    uint32_t events_tail;
+    bool events_overflowed;
+};
+
+static void animation_reactive_push(const struct device *dev, uint16_t pixel,
+                                    bool pressed) {
+    const struct animation_reactive_config *config = dev->config;
+    struct animation_reactive_data *data           = dev->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    if (data->events_tail - data->events_head <
+        CONFIG_ZMK_ANIMATION_REACTIVE_EVENTS) {
+        struct reactive_event *event =
+            &config->events[data->events_tail & REACTIVE_EVENTS_MASK];
+        event->pixel   = pixel;
+        event->pressed = pressed;
+        data->events_tail++;
+    } else {
+        data->events_overflowed = true;
+    }
+    k_spin_unlock(&data->lock, key);
+}
+
+static void animation_reactive_drain(const struct device *dev) {
+    const struct animation_reactive_config *config = dev->config;
+    struct animation_reactive_data *data           = dev->data;
+
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    if (data->events_overflowed) {
+        // releases may be lost, let all pixels fade out
+        LOG_WRN("Reactive events overflowed, increase "
+                "CONFIG_ZMK_ANIMATION_REACTIVE_EVENTS");
+        memset(config->held, 0, ZMK_ANIMATION_NUM_PIXELS);
+        data->events_overflowed = false;
+    }
+    for (; data->events_head != data->events_tail; data->events_head++) {
+        const struct reactive_event *event =
+            &config->events[data->events_head & REACTIVE_EVENTS_MASK];
+        if (event->pressed) {
+            config->held[event->pixel]++;
+            config->levels[event->pixel] = UINT8_MAX;
+        } else if (config->held[event->pixel] > 0) {
+            config->held[event->pixel]--;
+        }
+    }
+    k_spin_unlock(&data->lock, key);
+}
+
+static void animation_reactive_render_frame(const struct device *dev,
+                                            struct animation_pixel *pixels,
+                                            size_t num_pixels) {
+    const struct animation_reactive_config *config = dev->config;
+    struct animation_reactive_data *data           = dev->data;
+
+    if (!data->running) {
+        return;
+    }
+    animation_reactive_drain(dev);
+
+    uint32_t step = zmk_animation_get_frame_step();
+    uint32_t fade =
+        MAX(UINT8_MAX * step / MAX(config->fade_frames, 1), (uint32_t)1);
+    bool fading = false;
+    for (size_t i = 0; i < config->pixel_map_size; ++i) {
+        size_t pixel  = config->pixel_map[i];
+        uint8_t level = config->levels[pixel];
+        if (level == 0) {
+            // leave the pixel to animations below
+            continue;
+        }
+        pixels[pixel].value.r = data->rgb.r * level / UINT8_MAX;
+        pixels[pixel].value.g = data->rgb.g * level / UINT8_MAX;
+        pixels[pixel].value.b = data->rgb.b * level / UINT8_MAX;
+        if (config->held[pixel] == 0) {
+            config->levels[pixel] = level > fade ? level - fade : 0;
+            fading                = true;
+        }
+    }
+    data->fading = fading;
+
+    if (data->counter != ANIMATION_DURATION_FOREVER) {
+        data->counter = data->counter > step ? data->counter - step : 0;
+        if (data->counter == 0) {
+            data->running = false;
+            return;
+        }
+    }
+    if (fading) {
+        zmk_animation_request_frames(1);
+    }
+}
+
+static void animation_reactive_start(const struct device *dev,
+                                     uint32_t request_duration_ms) {
+    const struct animation_reactive_config *config = dev->config;
+    struct animation_reactive_data *data           = dev->data;
+
+    memset(config->levels, 0, ZMK_ANIMATION_NUM_PIXELS);
+    memset(config->held, 0, ZMK_ANIMATION_NUM_PIXELS);
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+    data->events_head       = data->events_tail;
+    data->events_overflowed = false;
+    k_spin_unlock(&data->lock, key);
+
+    data->counter = request_duration_ms == 0
+                        ? ANIMATION_DURATION_FOREVER
+                        : ANIMATION_DURATION_MS_TO_FRAMES(request_duration_ms);
+    data->fading  = false;
+    data->running = true;
+    zmk_animation_request_frames(1);
+    LOG_DBG("Start animation reactive");
+}
+
+static void animation_reactive_stop(const struct device *dev) {
+    struct animation_reactive_data *data = dev->data;
+    data->running                        = false;
+    LOG_DBG("Stop animation reactive");
+}
+
+static bool animation_reactive_is_finished(const struct device *dev) {
+    struct animation_reactive_data *data = dev->data;
+    return !data->running;
+}
+
+static uint32_t animation_reactive_get_period(const struct device *dev) {
+    struct animation_reactive_data *data = dev->data;
+    // static until the next key event, which invalidates the frame cache
+    return data->running && !data->fading &&
+                   data->counter == ANIMATION_DURATION_FOREVER
+               ? 1
+               : 0;
+}
+
+static size_t animation_reactive_get_pixel_map(const struct device *dev,
+                                               const size_t **pixel_map) {
+    const struct animation_reactive_config *config = dev->config;
+    *pixel_map                                     = config->pixel_map;
+    return config->pixel_map_size;
+}
+
+static int animation_reactive_init(const struct device *dev) {
+    const struct animation_reactive_config *config = dev->config;
+    struct animation_reactive_data *data           = dev->data;
+
+    zmk_hsl_to_rgb(config->color, &data->rgb);
+    // route the key positions whose pixel is rendered by this instance
+    for (size_t position = 0; position < ZMK_KEYMAP_LEN; ++position) {
+        size_t pixel = zmk_animation_get_pixel_by_key_position(position);
+        if (pixel == ZMK_ANIMATION_PIXEL_NONE) {
+            continue;
+        }
+        for (size_t i = 0; i < config->pixel_map_size; ++i) {
+            if (config->pixel_map[i] == pixel) {
+                routes[position].pixel = pixel;
+                routes[position].animations |= BIT(config->index);
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+static const struct animation_api animation_reactive_api = {
+    .on_start      = animation_reactive_start,
+    .on_stop       = animation_reactive_stop,
+    .render_frame  = animation_reactive_render_frame,
+    .is_finished   = animation_reactive_is_finished,
+    .get_period    = animation_reactive_get_period,
+    .get_pixel_map = animation_reactive_get_pixel_map,
+};
+
+#define ANIMATION_REACTIVE_DEVICE(idx)                                        \
+                                                                              \
+    static struct animation_reactive_data animation_reactive_##idx##_data;    \
+                                                                              \
+    static size_t animation_reactive_##idx##_pixel_map[] =                    \
+        DT_INST_PROP(idx, pixels);                                            \
+    static uint32_t animation_reactive_##idx##_color =                        \
+        DT_INST_PROP(idx, color);                                             \
+    static uint8_t                                                            \
+        animation_reactive_##idx##_levels[ZMK_ANIMATION_NUM_PIXELS];          \
+    static uint8_t animation_reactive_##idx##_held[ZMK_ANIMATION_NUM_PIXELS]; \
+    static struct reactive_event animation_reactive_##idx##_events            \
+        [CONFIG_ZMK_ANIMATION_REACTIVE_EVENTS];                               \
+                                                                              \
+    static const struct animation_reactive_config                             \
+        animation_reactive_##idx##_config = {                                 \
+            .pixel_map      = &animation_reactive_##idx##_pixel_map[0],       \
+            .pixel_map_size = DT_INST_PROP_LEN(idx, pixels),                  \
+            .color =                                                          \
+                (struct zmk_color_hsl *)&animation_reactive_##idx##_color,    \
+            .fade_frames    = ANIMATION_DURATION_MS_TO_FRAMES(                \
+                DT_INST_PROP(idx, fade_ms)),                                  \
+            .levels         = animation_reactive_##idx##_levels,              \
+            .held           = animation_reactive_##idx##_held,                \
+            .events         = animation_reactive_##idx##_events,              \
+            .index          = idx,                                            \
+    };                                                                        \
+                                                                              \
+    DEVICE_DT_INST_DEFINE(idx, &animation_reactive_init, NULL,                \
+                          &animation_reactive_##idx##_data,                   \
+                          &animation_reactive_##idx##_config, POST_KERNEL,    \
+                          CONFIG_APPLICATION_INIT_PRIORITY,                   \
+                          &animation_reactive_api);
+
+DT_INST_FOREACH_STATUS_OKAY(ANIMATION_REACTIVE_DEVICE);
+
+#define INST_TO_DEVICE(idx) [idx] = DEVICE_DT_INST_GET(idx),
+
+// indexed by the bits of reactive_route
+static const struct device *reactive_animations[] = {
+    DT_INST_FOREACH_STATUS_OKAY(INST_TO_DEVICE)};
+
+static int reactive_event_listener(const zmk_event_t *eh) {
+    const struct zmk_position_state_changed *ev =
+        as_zmk_position_state_changed(eh);
+    if (ev == NULL || ev->position >= ZMK_KEYMAP_LEN) {
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+    const struct reactive_route *route = &routes[ev->position];
+    uint32_t animations                = route->animations;
+    bool pushed                        = false;
+    while (animations != 0) {
+        uint8_t i = u32_count_trailing_zeros(animations);
+        animations &= animations - 1;
+        struct animation_reactive_data *data = reactive_animations[i]->data;
+        if (data->running) {
+            animation_reactive_push(reactive_animations[i], route->pixel,
+                                    ev->state);
+            pushed = true;
+        }
+    }
+    if (pushed) {
+        zmk_animation_invalidate_frame_cache();
+        zmk_animation_request_frames(1);
+    }
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(animation_reactive, reactive_event_listener);
+ZMK_SUBSCRIPTION(animation_reactive, zmk_position_state_changed);
+
+#endif
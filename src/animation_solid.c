@@ -12,10 +12,26 @@
 
 #include <zmk_driver_animation/color.h>
 #include <zmk_driver_animation/animation.h>
+#include <zmk_driver_animation/arena.h>
 #include <zmk_driver_animation/drivers/animation.h>
 
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
+// Running state. It's claimed on start and released on stop.
+struct animation_solid_state {
+    uint32_t counter;
+    uint16_t animation_counter;
+    // parameters of the run
+    uint16_t speed_percent;
+    // hundredths of a frame carried over to the next step
+    uint8_t speed_remainder;
+    uint8_t intensity;
+    bool fixed_color;
+
+    struct zmk_color_hsl current_hsl;
+    struct zmk_color_rgb current_rgb;
+};
+
 struct animation_solid_config {
     size_t *pixel_map;
     size_t pixel_map_size;
@@ -23,34 +39,55 @@ struct animation_solid_config {
     uint8_t num_colors;
     uint16_t duration;
     uint16_t transition_duration;
+    struct animation_solid_state *state_storage;
 };
 
 struct animation_solid_data {
-    uint32_t counter;
-    uint16_t animation_counter;
-
-    struct zmk_color_hsl current_hsl;
-    struct zmk_color_rgb current_rgb;
+    struct animation_solid_state *state;
 };
 
+static void animation_solid_apply_intensity(
+    struct animation_solid_state *state) {
+    if (state->intensity == UINT8_MAX) {
+        return;
+    }
+    float scale = state->intensity / (float)UINT8_MAX;
+    state->current_rgb.r *= scale;
+    state->current_rgb.g *= scale;
+    state->current_rgb.b *= scale;
+}
+
+static bool animation_solid_is_static(const struct device *dev) {
+    const struct animation_solid_config *config = dev->config;
+    struct animation_solid_data *data           = dev->data;
+    return config->num_colors == 1 || data->state->fixed_color;
+}
+
 static void animation_solid_update_color(const struct device *dev) {
     const struct animation_solid_config *config = dev->config;
     struct animation_solid_data *data           = dev->data;
+    struct animation_solid_state *state         = data->state;
 
-    const size_t from = data->animation_counter / config->transition_duration;
+    const size_t from = state->animation_counter / config->transition_duration;
     const size_t to   = (from + 1) % config->num_colors;
 
     struct zmk_color_hsl next_hsl;
 
     zmk_interpolate_hsl(
         &config->colors[from], &config->colors[to], &next_hsl,
-        (data->animation_counter % config->transition_duration) /
+        (state->animation_counter % config->transition_duration) /
             (float)config->transition_duration);
 
-    data->current_hsl = next_hsl;
-    zmk_hsl_to_rgb(&data->current_hsl, &data->current_rgb);
+    state->current_hsl = next_hsl;
+    zmk_hsl_to_rgb(&state->current_hsl, &state->current_rgb);
+    animation_solid_apply_intensity(state);
 
-    data->animation_counter = (data->animation_counter + 1) % config->duration;
+    // advance in hundredths of a frame so any speed other than 100% counts
+    uint32_t scaled = zmk_animation_get_frame_step() * state->speed_percent +
+                      state->speed_remainder;
+    state->speed_remainder   = scaled % 100;
+    state->animation_counter =
+        (state->animation_counter + scaled / 100) % config->duration;
 }
 
 static void animation_solid_render_frame(const struct device *dev,
@@ -58,80 +95,157 @@ static void animation_solid_render_frame(const struct device *dev,
                                          size_t num_pixels) {
     const struct animation_solid_config *config = dev->config;
     struct animation_solid_data *data           = dev->data;
+    struct animation_solid_state *state         = data->state;
+
+    if (state == NULL) {
+        return;
+    }
 
-    uint32_t counter = data->counter;
+    uint32_t counter = state->counter;
     if (counter == 0) {
         return;
     }
 
     for (size_t i = 0; i < config->pixel_map_size; ++i) {
-        pixels[config->pixel_map[i]].value = data->current_rgb;
+        pixels[config->pixel_map[i]].value = state->current_rgb;
     }
 
-    if (config->num_colors == 1 &&
-        data->counter == ANIMATION_DURATION_FOREVER) {
+    if (animation_solid_is_static(dev) &&
+        state->counter == ANIMATION_DURATION_FOREVER) {
         // optimization to stop render frame if animation is forever
         return;
     }
 
     if (counter < ANIMATION_DURATION_FOREVER) {
-        data->counter = counter - 1;
-        zmk_animation_request_frames_if_required(data->counter, false);
+        uint32_t step  = zmk_animation_get_frame_step();
+        state->counter = counter > step ? counter - step : 0;
+        zmk_animation_request_frames_if_required(state->counter, false);
+    }
+    if (animation_solid_is_static(dev)) {
+        return;
+    }
+    if (counter == ANIMATION_DURATION_FOREVER) {
+        // keep cycling colors
+        zmk_animation_request_frames_if_required(
+            config->duration - state->animation_counter, false);
     }
 
     animation_solid_update_color(dev);
 }
 
-static void animation_solid_start(const struct device *dev,
-                                  uint32_t request_duration_ms) {
-    // TODO: support request_duration_ms
-    struct animation_solid_data *data = dev->data;
-    data->counter                     = request_duration_ms == 0
-                                            ? ANIMATION_DURATION_FOREVER
-                                            : ANIMATION_DURATION_MS_TO_FRAMES(request_duration_ms);
-    data->animation_counter           = 0;
-    if (data->counter == ANIMATION_DURATION_FOREVER) {
-        // optimization to reduce render frame if animation is forever
-        zmk_animation_request_frames(1);
+static void animation_solid_start_with_params(
+    const struct device *dev, uint32_t request_duration_ms,
+    const struct animation_params *params) {
+    const struct animation_solid_config *config = dev->config;
+    struct animation_solid_data *data           = dev->data;
+    if (data->state == NULL) {
+        data->state = zmk_animation_state_claim(
+            config->state_storage, sizeof(struct animation_solid_state));
+        if (data->state == NULL) {
+            LOG_ERR("Failed to claim animation solid state");
+            return;
+        }
+    }
+    struct animation_solid_state *state = data->state;
+    state->counter           = request_duration_ms == 0
+                                   ? ANIMATION_DURATION_FOREVER
+                                   : ANIMATION_DURATION_MS_TO_FRAMES(request_duration_ms);
+    state->animation_counter = 0;
+    state->speed_percent     = 100;
+    state->speed_remainder   = 0;
+    state->intensity         = UINT8_MAX;
+    state->fixed_color       = false;
+    state->current_hsl       = config->colors[0];
+    if (params != NULL) {
+        if (params->flags & ANIMATION_PARAM_SPEED) {
+            state->speed_percent = MAX(params->speed_percent, 1);
+        }
+        if (params->flags & ANIMATION_PARAM_INTENSITY) {
+            state->intensity = params->intensity;
+        }
+        if (params->flags & ANIMATION_PARAM_COLOR) {
+            state->fixed_color = true;
+            state->current_hsl = params->color;
+        }
+    }
+    if (animation_solid_is_static(dev)) {
+        zmk_hsl_to_rgb(&state->current_hsl, &state->current_rgb);
+        animation_solid_apply_intensity(state);
     } else {
-        zmk_animation_request_frames_if_required(data->counter, true);
+        // the first frame shows colors[0] at counter 0, so each frame of a
+        // period shows a different step
+        animation_solid_update_color(dev);
+    }
+    if (state->counter == ANIMATION_DURATION_FOREVER) {
+        // single color animation needs only one frame if it runs forever
+        zmk_animation_request_frames(
+            animation_solid_is_static(dev) ? 1 : CONFIG_ZMK_ANIMATION_FPS);
+    } else {
+        zmk_animation_request_frames_if_required(state->counter, true);
     }
     LOG_INF("Start animation solid");
 }
 
+static void animation_solid_start(const struct device *dev,
+                                  uint32_t request_duration_ms) {
+    animation_solid_start_with_params(dev, request_duration_ms, NULL);
+}
+
 static void animation_solid_stop(const struct device *dev) {
-    struct animation_solid_data *data = dev->data;
-    data->counter                     = 0;
+    struct animation_solid_data *data   = dev->data;
+    struct animation_solid_state *state = data->state;
+    data->state                         = NULL;
+    zmk_animation_state_release(state);
     LOG_INF("Stop animation solid");
 }
 
 static bool animation_solid_is_finished(const struct device *dev) {
-    struct animation_solid_data *data = dev->data;
-    return data->counter == 0;
+    struct animation_solid_data *data   = dev->data;
+    struct animation_solid_state *state = data->state;
+    return state == NULL || state->counter == 0;
 }
 
-static int animation_solid_init(const struct device *dev) {
+static uint32_t animation_solid_get_period(const struct device *dev) {
     const struct animation_solid_config *config = dev->config;
     struct animation_solid_data *data           = dev->data;
+    struct animation_solid_state *state         = data->state;
+    if (state == NULL || state->counter != ANIMATION_DURATION_FOREVER) {
+        return 0;
+    }
+    if (animation_solid_is_static(dev)) {
+        return 1;
+    }
+    // colors don't repeat at a fixed frame count at other speeds
+    return state->speed_percent == 100 ? config->duration : 0;
+}
 
-    data->current_hsl = config->colors[0];
-
-    zmk_hsl_to_rgb(&data->current_hsl, &data->current_rgb);
-
-    return 0;
+static size_t animation_solid_get_pixel_map(const struct device *dev,
+                                            const size_t **pixel_map) {
+    const struct animation_solid_config *config = dev->config;
+    *pixel_map                                  = config->pixel_map;
+    return config->pixel_map_size;
 }
 
+static int animation_solid_init(const struct device *dev) { return 0; }
+
 static const struct animation_api animation_solid_api = {
-    .on_start     = animation_solid_start,
-    .on_stop      = animation_solid_stop,
-    .render_frame = animation_solid_render_frame,
-    .is_finished  = animation_solid_is_finished,
+    .on_start             = animation_solid_start,
+    .on_stop              = animation_solid_stop,
+    .render_frame         = animation_solid_render_frame,
+    .is_finished          = animation_solid_is_finished,
+    .get_period           = animation_solid_get_period,
+    .get_pixel_map        = animation_solid_get_pixel_map,
+    .fills_pixel_map      = true,
+    .on_start_with_params = animation_solid_start_with_params,
 };
 
 #define ANIMATION_SOLID_DEVICE(idx)                                           \
                                                                               \
     static struct animation_solid_data animation_solid_##idx##_data;          \
                                                                               \
+    ZMK_ANIMATION_STATE_DEFINE(animation_solid_##idx##_state,                 \
+                               struct animation_solid_state)                  \
+                                                                              \
     static size_t animation_ripple_##idx##_pixel_map[] =                      \
         DT_INST_PROP(idx, pixels);                                            \
                                                                               \
@@ -147,6 +261,8 @@ static const struct animation_api animation_solid_api = {
         .transition_duration =                                                \
             (DT_INST_PROP(idx, duration) * CONFIG_ZMK_ANIMATION_FPS) /        \
             DT_INST_PROP_LEN(idx, colors),                                    \
+        .state_storage =                                                      \
+            ZMK_ANIMATION_STATE_STORAGE(animation_solid_##idx##_state),       \
     };                                                                        \
                                                                               \
     DEVICE_DT_INST_DEFINE(                                                    \
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2025 cormoran
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define DT_DRV_COMPAT zmk_animation_ws2812_spi
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/led_strip.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/dt-bindings/led/led.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+/*
+ * WS2812 driver over SPI. Each bit of a color channel is sent as one SPI byte
+ * (spi-one-frame or spi-zero-frame), so each channel takes 8 SPI bytes.
+ *
+ * The SPI buffer is kept between updates. Channels are encoded through a
+ * lookup table of 4 SPI bytes per nibble, and channels which didn't change
+ * since the previous update are not encoded again.
+ */
+
+#define SPI_BYTES_PER_CHANNEL 8
+#define SPI_BYTES_PER_NIBBLE 4
+
+#define SPI_OPER                                               \
+    (SPI_OP_MODE_MASTER | SPI_TRANSFER_MSB | SPI_WORD_SET(8) | \
+     SPI_LINES_SINGLE)
+
+struct ws2812_spi_config {
+    struct spi_dt_spec bus;
+    uint8_t *px_buf;
+    uint8_t *channels;
+    const uint8_t *color_mapping;
+    size_t num_colors;
+    size_t length;
+    uint8_t one_frame;
+    uint8_t zero_frame;
+    uint16_t reset_delay;
+};
+
+struct ws2812_spi_data {
+    // SPI bytes for each nibble value, most significant bit first
+    uint8_t nibbles[16][SPI_BYTES_PER_NIBBLE];
+    // false until every channel is encoded once
+    bool encoded;
+};
+
+static inline void ws2812_spi_encode_channel(const struct ws2812_spi_data *data,
+                                             uint8_t value, uint8_t *buf) {
+    memcpy(buf, data->nibbles[value >> 4], SPI_BYTES_PER_NIBBLE);
+    memcpy(buf + SPI_BYTES_PER_NIBBLE, data->nibbles[value & 0x0f],
+           SPI_BYTES_PER_NIBBLE);
+}
+
+static inline uint8_t ws2812_spi_channel_value(const struct led_rgb *pixel,
+                                               uint8_t color_id) {
+    switch (color_id) {
+        case LED_COLOR_ID_RED:
+            return pixel->r;
+        case LED_COLOR_ID_GREEN:
+            return pixel->g;
+        case LED_COLOR_ID_BLUE:
+            return pixel->b;
+#if IS_ENABLED(CONFIG_LED_STRIP_RGB_SCRATCH)
+        case LED_COLOR_ID_WHITE:
+            // white channel of RGBW LEDs, see output-rgbw of zmk,animation
+            return pixel->scratch;
+#endif
+        default:
+            return 0;
+    }
+}
+
+static int ws2812_spi_update_rgb(const struct device *dev,
+                                 struct led_rgb *pixels, size_t num_pixels) {
+    const struct ws2812_spi_config *config = dev->config;
+    struct ws2812_spi_data *data           = dev->data;
+
+    if (num_pixels > config->length) {
+        LOG_ERR("%zu pixels exceed chain length %zu", num_pixels,
+                config->length);
+        return -EINVAL;
+    }
+
+    size_t channel = 0;
+    for (size_t i = 0; i < num_pixels; ++i) {
+        for (size_t j = 0; j < config->num_colors; ++j, ++channel) {
+            uint8_t value =
+                ws2812_spi_channel_value(&pixels[i], config->color_mapping[j]);
+            if (data->encoded && config->channels[channel] == value) {
+                continue;
+            }
+            config->channels[channel] = value;
+            ws2812_spi_encode_channel(
+                data, value, &config->px_buf[channel * SPI_BYTES_PER_CHANNEL]);
+        }
+    }
+    data->encoded = data->encoded || num_pixels == config->length;
+
+    const struct spi_buf buf = {
+        .buf = config->px_buf,
+        .len = channel * SPI_BYTES_PER_CHANNEL,
+    };
+    const struct spi_buf_set tx = {
+        .buffers = &buf,
+        .count   = 1,
+    };
+    int rc = spi_write_dt(&config->bus, &tx);
+    if (rc != 0) {
+        LOG_ERR("Failed to write pixels: %d", rc);
+        return rc;
+    }
+    // latch the data
+    k_usleep(config->reset_delay);
+    return 0;
+}
+
+static int ws2812_spi_update_channels(const struct device *dev,
+                                      uint8_t *channels, size_t num_channels) {
+    return -ENOTSUP;
+}
+
+static int ws2812_spi_init(const struct device *dev) {
+    const struct ws2812_spi_config *config = dev->config;
+    struct ws2812_spi_data *data           = dev->data;
+
+    if (!spi_is_ready_dt(&config->bus)) {
+        LOG_ERR("SPI device %s not ready", config->bus.bus->name);
+        return -ENODEV;
+    }
+
+    for (size_t i = 0; i < config->num_colors; ++i) {
+        switch (config->color_mapping[i]) {
+            case LED_COLOR_ID_RED:
+            case LED_COLOR_ID_GREEN:
+            case LED_COLOR_ID_BLUE:
+#if IS_ENABLED(CONFIG_LED_STRIP_RGB_SCRATCH)
+            case LED_COLOR_ID_WHITE:
+#endif
+                break;
+            default:
+                LOG_ERR("%s: invalid channel to color mapping", dev->name);
+                return -EINVAL;
+        }
+    }
+
+    for (uint8_t nibble = 0; nibble < 16; ++nibble) {
+        for (uint8_t bit = 0; bit < SPI_BYTES_PER_NIBBLE; ++bit) {
+            data->nibbles[nibble][bit] = (nibble & BIT(3 - bit))
+                                             ? config->one_frame
+                                             : config->zero_frame;
+        }
+    }
+    data->encoded = false;
+
+    return 0;
+}
+
+static const struct led_strip_driver_api ws2812_spi_api = {
+    .update_rgb      = ws2812_spi_update_rgb,
+    .update_channels = ws2812_spi_update_channels,
+};
+
+#define WS2812_SPI_NUM_COLORS(idx) DT_INST_PROP_LEN(idx, color_mapping)
+
+#define WS2812_SPI_NUM_CHANNELS(idx) \
+    (DT_INST_PROP(idx, chain_length) * WS2812_SPI_NUM_COLORS(idx))
+
+#define WS2812_SPI_DEVICE(idx)                                                \
+                                                                              \
+    static uint8_t ws2812_spi_##idx##_px_buf[WS2812_SPI_NUM_CHANNELS(idx) *   \
+                                             SPI_BYTES_PER_CHANNEL];          \
+    static uint8_t ws2812_spi_##idx##_channels[WS2812_SPI_NUM_CHANNELS(idx)]; \
+    static const uint8_t ws2812_spi_##idx##_color_mapping[] =                 \
+        DT_INST_PROP(idx, color_mapping);                                     \
+                                                                              \
+    static struct ws2812_spi_data ws2812_spi_##idx##_data;                    \
+                                                                              \
+    static const struct ws2812_spi_config ws2812_spi_##idx##_config = {       \
+        .bus           = SPI_DT_SPEC_INST_GET(idx, SPI_OPER, 0),              \
+        .px_buf        = ws2812_spi_##idx##_px_buf,                           \
+        .channels      = ws2812_spi_##idx##_channels,                         \
+        .color_mapping = ws2812_spi_##idx##_color_mapping,                    \
+        .num_colors    = WS2812_SPI_NUM_COLORS(idx),                          \
+        .length        = DT_INST_PROP(idx, chain_length),                     \
+        .one_frame     = DT_INST_PROP(idx, spi_one_frame),                    \
+        .zero_frame    = DT_INST_PROP(idx, spi_zero_frame),                   \
+        .reset_delay   = DT_INST_PROP(idx, reset_delay),                      \
+    };                                                                        \
+                                                                              \
+    DEVICE_DT_INST_DEFINE(idx, &ws2812_spi_init, NULL,                        \
+                          &ws2812_spi_##idx##_data,                           \
+                          &ws2812_spi_##idx##_config, POST_KERNEL,            \
+                          CONFIG_LED_STRIP_INIT_PRIORITY, &ws2812_spi_api);
+
+DT_INST_FOREACH_STATUS_OKAY(WS2812_SPI_DEVICE);
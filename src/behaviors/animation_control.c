@@ -37,6 +37,9 @@ static int on_keymap_binding_pressed(struct zmk_behavior_binding *binding,
             animation_control_change_brightness0(
                 binding->param2, ANIMATION_CONTROL_POWER_SOURCE_CURRENT);
             return 0;
+        case ANIMATION_CONTROL_CMD_FRAME_RATE:
+            animation_control_set_frame_divider0(binding->param2);
+            return 0;
         default:
             LOG_ERR("Unknown command: %d", binding->param1);
     }
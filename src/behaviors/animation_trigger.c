@@ -22,138 +22,183 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 
 #if DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT)
 
+#define TRIGGER_NUM_ANIMATIONS \
+    DT_PROP_LEN(DT_CHOSEN(zmk_animation_control), behavior_animations)
+
 struct trigger_status {
     bool triggered;
-    uint8_t index;
     uint8_t num_pressed;
-    uint32_t remaining_duration_ms;
+    // position in trigger_deadlines while triggered
+    uint8_t heap_index;
+    // uptime in ms at which the animation stops unless the key is held
+    int64_t deadline;
+    // handle of the played animation to stop exactly what was started
+    int handle;
 };
-// TODO: directly mapping animation index to [i] is simpler
-static struct trigger_status
-    trigger_statuses[CONFIG_ZMK_ANIMATION_TRIGGER_MAX_PARALELISM] = {};
+
+// indexed by animation index
+static struct trigger_status trigger_statuses[TRIGGER_NUM_ANIMATIONS] = {};
+// min-heap of triggered animation indices ordered by deadline
+static uint8_t trigger_deadlines[TRIGGER_NUM_ANIMATIONS];
+static size_t num_triggered = 0;
 static struct k_mutex mutex;
 static struct k_work_delayable animation_stop_work;
-static uint32_t last_work_time = 0;
 
-static uint8_t find_trigger_status_index(uint8_t index) {
-    for (int i = 0; i < CONFIG_ZMK_ANIMATION_TRIGGER_MAX_PARALELISM; i++) {
-        if (trigger_statuses[i].triggered &&
-            trigger_statuses[i].index == index) {
-            return i;
-        }
+BUILD_ASSERT(TRIGGER_NUM_ANIMATIONS <= UINT8_MAX + 1,
+             "Too many behavior-animations for animation trigger");
+
+static inline int64_t deadline_at(size_t heap_index) {
+    return trigger_statuses[trigger_deadlines[heap_index]].deadline;
+}
+
+static void heap_set(size_t heap_index, uint8_t animation_index) {
+    trigger_deadlines[heap_index]                = animation_index;
+    trigger_statuses[animation_index].heap_index = heap_index;
+}
+
+static void heap_sift_up(size_t i) {
+    uint8_t animation_index = trigger_deadlines[i];
+    int64_t deadline        = trigger_statuses[animation_index].deadline;
+    while (i > 0 && deadline_at((i - 1) / 2) > deadline) {
+        heap_set(i, trigger_deadlines[(i - 1) / 2]);
+        i = (i - 1) / 2;
     }
-    return CONFIG_ZMK_ANIMATION_TRIGGER_MAX_PARALELISM;
+    heap_set(i, animation_index);
 }
 
-static uint8_t find_empty_index() {
-    for (int i = 0; i < CONFIG_ZMK_ANIMATION_TRIGGER_MAX_PARALELISM; i++) {
-        if (!trigger_statuses[i].triggered) {
-            return i;
+static void heap_sift_down(size_t i) {
+    uint8_t animation_index = trigger_deadlines[i];
+    int64_t deadline        = trigger_statuses[animation_index].deadline;
+    while (2 * i + 1 < num_triggered) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < num_triggered &&
+            deadline_at(child + 1) < deadline_at(child)) {
+            child++;
+        }
+        if (deadline_at(child) >= deadline) {
+            break;
         }
+        heap_set(i, trigger_deadlines[child]);
+        i = child;
+    }
+    heap_set(i, animation_index);
+}
+
+static void heap_push(uint8_t animation_index) {
+    heap_set(num_triggered, animation_index);
+    heap_sift_up(num_triggered++);
+}
+
+static void heap_remove(uint8_t animation_index) {
+    size_t i = trigger_statuses[animation_index].heap_index;
+    num_triggered--;
+    if (i < num_triggered) {
+        // move the last deadline into the hole
+        uint8_t moved = trigger_deadlines[num_triggered];
+        heap_set(i, moved);
+        heap_sift_up(i);
+        heap_sift_down(trigger_statuses[moved].heap_index);
+    }
+}
+
+static void reset_trigger_status(uint8_t animation_index) {
+    struct trigger_status reset = {};
+    heap_remove(animation_index);
+    trigger_statuses[animation_index] = reset;
+}
+
+/**
+ * Schedule the work at the nearest deadline. Called with the mutex held.
+ */
+static void schedule_next_deadline(int64_t now) {
+    if (num_triggered == 0) {
+        LOG_DBG("Skip rescheduling work");
+        k_work_cancel_delayable(&animation_stop_work);
+        return;
+    }
+    int64_t delay = MAX(deadline_at(0) - now, 0);
+    LOG_DBG("reschedule %lld", delay);
+    int rc = k_work_reschedule(&animation_stop_work, K_MSEC(delay));
+    if (rc < 0) {
+        LOG_ERR("Failed to schedule work: %d", rc);
     }
-    return CONFIG_ZMK_ANIMATION_TRIGGER_MAX_PARALELISM;
 }
 
 static void animation_stop_work_handler(struct k_work *work) {
-    LOG_DBG("");
-    int64_t now            = k_uptime_get();
-    uint32_t elapsed       = now - last_work_time;
-    uint32_t min_remaining = 0;
-    for (int i = 0; i < CONFIG_ZMK_ANIMATION_TRIGGER_MAX_PARALELISM; i++) {
-        if (!trigger_statuses[i].triggered) {
-            continue;
-        }
-        int rc = k_mutex_lock(&mutex, K_FOREVER);
-        if (rc != 0) {
-            LOG_ERR("Failed to lock mutex: %d", rc);
-            return;
-        }
-        struct trigger_status s = trigger_statuses[i];  // copy
-        if (!s.triggered) {
-            k_mutex_unlock(&mutex);
-            continue;
-        }
-        if (s.remaining_duration_ms > elapsed) {
-            s.remaining_duration_ms -= elapsed;
-            if (min_remaining < s.remaining_duration_ms) {
-                min_remaining = s.remaining_duration_ms;
-            }
-            trigger_statuses[i] = s;
-            k_mutex_unlock(&mutex);
-            continue;
-        }
-        if (s.num_pressed > 0) {
-            s.remaining_duration_ms =
-                CONFIG_ZMK_ANIMATION_TRIGGER_EXTEND_MS_ON_HOLD;
-            if (min_remaining < s.remaining_duration_ms) {
-                min_remaining = s.remaining_duration_ms;
-            }
-            trigger_statuses[i] = s;
-            k_mutex_unlock(&mutex);
-            continue;
-        }
-        animation_control_stop_by_index0(s.index);
-        struct trigger_status reset = {};
-        trigger_statuses[i]         = reset;
-        k_mutex_unlock(&mutex);
+    int rc = k_mutex_lock(&mutex, K_FOREVER);
+    if (rc != 0) {
+        LOG_ERR("Failed to lock mutex: %d", rc);
+        return;
     }
-    last_work_time = now;
-    if (min_remaining > 0) {
-        LOG_DBG("reschedule %d", min_remaining);
-        int rc = k_work_schedule(&animation_stop_work, K_MSEC(min_remaining));
-        if (rc < 0) {
-            LOG_ERR("Failed to schedule work: %d", rc);
+    int64_t now = k_uptime_get();
+    while (num_triggered > 0 && deadline_at(0) <= now) {
+        uint8_t index            = trigger_deadlines[0];
+        struct trigger_status *s = &trigger_statuses[index];
+        if (animation_control_get_state0(s->handle) ==
+            ANIMATION_CONTROL_HANDLE_DONE) {
+            // finished or replaced by another animation
+            LOG_DBG("Animation %d already done", index);
+            reset_trigger_status(index);
+        } else if (s->num_pressed > 0) {
+            s->deadline = now + CONFIG_ZMK_ANIMATION_TRIGGER_EXTEND_MS_ON_HOLD;
+            heap_sift_down(0);
+        } else {
+            animation_control_cancel0(s->handle);
+            reset_trigger_status(index);
         }
-    } else {
-        LOG_DBG("Skip rescheduling work");
     }
+    schedule_next_deadline(now);
+    k_mutex_unlock(&mutex);
 }
 
 static int on_keymap_binding_pressed(struct zmk_behavior_binding *binding,
                                      struct zmk_behavior_binding_event event) {
     switch (binding->param1) {
         case ANIMATION_TRIGGER_CMD_TRIGGER:
+            uint8_t animation_index = binding->param2;
+            if (animation_index >= TRIGGER_NUM_ANIMATIONS) {
+                LOG_ERR("Animation %d out of range", animation_index);
+                return -EINVAL;
+            }
             int rc = k_mutex_lock(&mutex, K_FOREVER);
             if (rc != 0) {
                 LOG_ERR("Failed to lock mutex: %d", rc);
                 return rc;
             }
-            uint8_t animation_index = binding->param2;
-            uint8_t index = find_trigger_status_index(animation_index);
-            if (index < CONFIG_ZMK_ANIMATION_TRIGGER_MAX_PARALELISM) {
+            struct trigger_status *s = &trigger_statuses[animation_index];
+            if (s->triggered && animation_control_get_state0(s->handle) ==
+                                    ANIMATION_CONTROL_HANDLE_DONE) {
+                // replaced by another animation, trigger again
+                reset_trigger_status(animation_index);
+            }
+            if (s->triggered) {
                 LOG_INF("Animation %d already triggered", animation_index);
-                trigger_statuses[index].num_pressed++;
+                s->num_pressed++;
                 k_mutex_unlock(&mutex);
                 return ZMK_BEHAVIOR_OPAQUE;
             }
-            index = find_empty_index();
-            if (index >= CONFIG_ZMK_ANIMATION_TRIGGER_MAX_PARALELISM) {
+            if (num_triggered >= CONFIG_ZMK_ANIMATION_TRIGGER_MAX_PARALELISM) {
                 LOG_ERR("No empty space for animation %d", animation_index);
                 k_mutex_unlock(&mutex);
                 return -ENOTSUP;
             }
-            trigger_statuses[index].triggered   = true;
-            trigger_statuses[index].index       = animation_index;
-            trigger_statuses[index].num_pressed = 1;
-            trigger_statuses[index].remaining_duration_ms =
-                CONFIG_ZMK_ANIMATION_TRIGGER_MIN_DURATION_MS;
-            k_mutex_unlock(&mutex);
             rc = animation_control_play_now_by_index0(
-                binding->param2, true,
+                animation_index, true,
                 CONFIG_ZMK_ANIMATION_TRIGGER_MAX_DURATION_MS);
-            if (rc != 0) {
-                LOG_ERR("Failed to play animation %d: %d", binding->param2, rc);
-                return rc;
-            }
-            rc = k_work_schedule(
-                &animation_stop_work,
-                K_MSEC(CONFIG_ZMK_ANIMATION_TRIGGER_MIN_DURATION_MS));
             if (rc < 0) {
-                LOG_ERR("Failed to schedule work: %d", rc);
+                LOG_ERR("Failed to play animation %d: %d", animation_index, rc);
+                k_mutex_unlock(&mutex);
                 return rc;
             }
+            int64_t now    = k_uptime_get();
+            s->triggered   = true;
+            s->num_pressed = 1;
+            s->deadline    = now + CONFIG_ZMK_ANIMATION_TRIGGER_MIN_DURATION_MS;
+            s->handle      = rc;
+            heap_push(animation_index);
+            schedule_next_deadline(now);
+            k_mutex_unlock(&mutex);
             return ZMK_BEHAVIOR_OPAQUE;
-            break;
         default:
             LOG_ERR("Unknown command: %d", binding->param1);
             return -ENOTSUP;
@@ -165,16 +210,18 @@ static int on_keymap_binding_released(struct zmk_behavior_binding *binding,
     switch (binding->param1) {
         case ANIMATION_TRIGGER_CMD_TRIGGER:
             uint8_t animation_index = binding->param2;
-            int rc                  = k_mutex_lock(&mutex, K_FOREVER);
+            if (animation_index >= TRIGGER_NUM_ANIMATIONS) {
+                return -EINVAL;
+            }
+            int rc = k_mutex_lock(&mutex, K_FOREVER);
             if (rc != 0) {
                 LOG_ERR("Failed to lock mutex: %d", rc);
                 return rc;
             }
-            uint8_t index = find_trigger_status_index(animation_index);
-            if (index < CONFIG_ZMK_ANIMATION_TRIGGER_MAX_PARALELISM) {
+            struct trigger_status *s = &trigger_statuses[animation_index];
+            if (s->triggered) {
                 LOG_DBG("Animation %d released", animation_index);
-                uint8_t np = trigger_statuses[index].num_pressed;
-                trigger_statuses[index].num_pressed = np > 0 ? np - 1 : 0;
+                s->num_pressed = s->num_pressed > 0 ? s->num_pressed - 1 : 0;
             } else {
                 LOG_INF("Animation %d looks already stopped", animation_index);
             }